@@ -17,6 +17,13 @@ lcov --capture --initial --directory . --output-file tdigest_base.info
 
 # Excute tests
 ./tests/AvlTreeTest
+./tests/ArrayTreeTest
+./tests/TDigestTest
+./tests/ParallelTest
+./tests/AccuracyTest
+./tests/ProfileTest
+./tests/ServerTest
+./tests/CliTest
 
 # Make
 lcov --no-checksum --directory . --capture --output-file tdigest.info
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "../tdigest/tdigest.hpp"
+#include "../tests/distributions.hpp"
+
+
+using namespace std;
+
+//
+// Streams each distribution into digests of each index and storage and
+// compares their quantiles with the exact ones of the sorted samples:
+// - max and mean rank error over 1000 quantiles, as fractions of the
+//   samples
+// - ns per add() and per quantile()
+//
+// Usage: accuracy_bench [samples] [--csv]
+//
+
+typedef chrono::steady_clock Clock;
+
+static double nanosSince(Clock::time_point start, size_t ops) {
+    return chrono::duration<double, nano>(Clock::now() - start).count() / ops;
+}
+
+static bool csv = false;
+
+template <typename Digest>
+static void run(const char* name, Distribution distribution,
+        const vector<double>& values, const vector<double>& sorted) {
+    Digest digest(100);
+    Clock::time_point start = Clock::now();
+    digest.add(values.data(), values.size());
+    const double addNs = nanosSince(start, values.size());
+
+    const size_t queries = 999;
+    vector<double> estimates(queries);
+    start = Clock::now();
+    for(size_t i = 0; i < queries; i++) {
+        estimates[i] = digest.quantile((i + 1) / 1000.);
+    }
+    const double quantileNs = nanosSince(start, queries);
+
+    double maxError = 0;
+    double sumError = 0;
+    for(size_t i = 0; i < queries; i++) {
+        const double error = rankError(sorted, (i + 1) / 1000., estimates[i]);
+        maxError = max(maxError, error);
+        sumError += error;
+    }
+
+    if(csv) {
+        cout << distributionName(distribution) << ',' << name << ',' << values.size() << ','
+             << digest.centroids()->size() << ',' << maxError << ',' << sumError / queries << ','
+             << addNs << ',' << quantileNs << endl;
+        return;
+    }
+    cout << setw(12) << distributionName(distribution) << setw(14) << name
+         << setw(10) << digest.centroids()->size() << scientific << setprecision(2)
+         << setw(12) << maxError << setw(12) << sumError / queries << fixed << setprecision(1)
+         << setw(10) << addNs << setw(12) << quantileNs << endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t samples = 1000 * 1000;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            samples = atol(argv[i]);
+        }
+    }
+
+    if(csv) {
+        cout << "distribution,digest,samples,centroids,max_rank_error,mean_rank_error,ns_add,ns_quantile" << endl;
+    } else {
+        cout << samples << " samples" << endl;
+        cout << "distribution        digest centroids   max error  mean error    ns/add ns/quantile" << endl;
+    }
+
+    for(Distribution distribution : allDistributions) {
+        const vector<double> values = generate(distribution, samples);
+        vector<double> sorted(values);
+        sort(sorted.begin(), sorted.end());
+
+        run<TDigest>("avl", distribution, values, sorted);
+        run<BasicTDigest<FloatStorage>>("avl/float", distribution, values, sorted);
+        run<BasicTDigest<CompactStorage>>("avl/compact", distribution, values, sorted);
+        run<BasicTDigest<DefaultStorage, BasicArrayTree>>("array", distribution, values, sorted);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../tdigest/tdigest.hpp"
+
+
+using namespace std;
+
+//
+// Compares the centroid indexes, BasicAvlTree and BasicArrayTree:
+// - ns per floor() and floorSum() lookup, and per insertion of a new
+//   centroid, for several numbers of centroids
+// - ns per add() and quantile() of a digest using each of them
+//
+
+typedef chrono::steady_clock Clock;
+
+static double nanosSince(Clock::time_point start, size_t ops) {
+    return chrono::duration<double, nano>(Clock::now() - start).count() / ops;
+}
+
+template <typename Tree>
+static void runIndex(const char* name, size_t n) {
+    mt19937_64 gen(1);
+    uniform_real_distribution<double> distribution(0, 1e6);
+    vector<double> values(n);
+    for(double& x : values) {
+        x = distribution(gen);
+    }
+
+    Tree tree;
+    Clock::time_point start = Clock::now();
+    for(double x : values) {
+        tree.add(x, 1);
+    }
+    const double insertNs = nanosSince(start, n);
+
+    const size_t lookups = 1000 * 1000;
+    vector<double> keys(4096);
+    for(double& x : keys) {
+        x = distribution(gen);
+    }
+    volatile long sink = 0;
+    start = Clock::now();
+    for(size_t i = 0; i < lookups; i++) {
+        sink = sink + tree.floor(keys[i % keys.size()]);
+    }
+    const double floorNs = nanosSince(start, lookups);
+
+    start = Clock::now();
+    for(size_t i = 0; i < lookups; i++) {
+        sink = sink + tree.floorSum(i % n);
+    }
+    const double floorSumNs = nanosSince(start, lookups);
+
+    cout << setw(10) << name << setw(10) << n << fixed << setprecision(1)
+         << setw(12) << insertNs << setw(12) << floorNs << setw(12) << floorSumNs << endl;
+}
+
+template <typename Digest>
+static void runDigest(const char* name, const vector<double>& values) {
+    Digest digest(100);
+    Clock::time_point start = Clock::now();
+    for(double x : values) {
+        digest.add(x);
+    }
+    const double addNs = nanosSince(start, values.size());
+
+    const size_t queries = 100 * 1000;
+    volatile double sink = 0;
+    start = Clock::now();
+    for(size_t i = 0; i < queries; i++) {
+        sink = sink + digest.quantile((i % 999 + 1) / 1000.);
+    }
+    const double quantileNs = nanosSince(start, queries);
+
+    cout << setw(10) << name << setw(12) << digest.centroids()->size() << fixed << setprecision(1)
+         << setw(12) << addNs << setw(12) << quantileNs << endl;
+}
+
+int main(int argc, char *argv[]) {
+    const size_t samples = argc > 1 ? atol(argv[1]) : 1000 * 1000;
+
+    cout << "     index centroids   ns/insert    ns/floor ns/floorSum" << endl;
+    for(size_t n : {100, 1000, 10000, 100000}) {
+        runIndex<AvlTree>("avl", n);
+        runIndex<ArrayTree>("array", n);
+    }
+
+    mt19937_64 gen(1);
+    lognormal_distribution<double> distribution(0, 1.5);
+    vector<double> values(samples);
+    for(double& x : values) {
+        x = distribution(gen);
+    }
+
+    cout << endl << samples << " lognormal samples" << endl;
+    cout << "     index   centroids      ns/add ns/quantile" << endl;
+    runDigest<TDigest>("avl", values);
+    runDigest<BasicTDigest<DefaultStorage, BasicArrayTree>>("array", values);
+
+    return EXIT_SUCCESS;
+}
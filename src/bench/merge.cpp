@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../tdigest/parallel.hpp"
+
+
+using namespace std;
+
+//
+// Speedup of parallelMerge with the number of threads, from 1 to twice
+// the hardware threads, merging the same digests each time.
+//
+
+typedef chrono::steady_clock Clock;
+
+int main(int argc, char *argv[]) {
+    const size_t digestCount = argc > 1 ? atol(argv[1]) : 2000;
+    const size_t samples = argc > 2 ? atol(argv[2]) : 1000;
+
+    // Build once, each run decodes its own copy
+    vector<string> encoded(digestCount);
+    mt19937_64 gen(1);
+    lognormal_distribution<double> distribution(0, 1.5);
+    for(string& e : encoded) {
+        TDigest digest(100);
+        for(size_t i = 0; i < samples; i++) {
+            digest.add(distribution(gen));
+        }
+        digest.serialize(e);
+    }
+
+    cout << digestCount << " digests of " << samples << " samples" << endl;
+    cout << "threads  ms        speedup  median" << endl;
+
+    const size_t maxThreads = 2 * max(1u, thread::hardware_concurrency());
+    double baseline = 0;
+    for(size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        vector<unique_ptr<TDigest>> owned;
+        vector<TDigest*> digests;
+        for(const string& e : encoded) {
+            owned.emplace_back(new TDigest(100));
+            owned.back()->merge(e.data(), e.size());
+            digests.push_back(owned.back().get());
+        }
+
+        ThreadPool pool(threads);
+        const Clock::time_point start = Clock::now();
+        parallelMerge(digests, pool);
+        const double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+        if(threads == 1) {
+            baseline = ms;
+        }
+
+        cout << setw(7) << threads
+             << "  " << setw(8) << fixed << setprecision(1) << ms
+             << "  " << setw(7) << setprecision(2) << baseline / ms
+             << "  " << setprecision(6) << digests[0]->quantile(0.5) << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../tdigest/tdigest.hpp"
+
+
+using namespace std;
+
+//
+// Runs ingestion, merge and query scenarios, reporting for each the
+// hardware counters read with perf_event_open and the per-phase timings
+// recorded by the TDIGEST_PROFILE hooks, with the estimated cost of the
+// hooks themselves.
+//
+// Counters need perf_event_paranoid <= 2 (or CAP_PERFMON); without them
+// only the phase timings are reported.
+//
+
+typedef chrono::steady_clock Clock;
+
+struct Counter {
+    const char* name;
+    uint32_t    type;
+    uint64_t    config;
+};
+
+static const Counter kCounters[] = {
+    {"cycles",          PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-refs",      PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache-misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branches",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch-misses",   PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"L1d-misses",      PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                            | PERF_COUNT_HW_CACHE_OP_READ << 8
+                                            | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+};
+
+static const size_t kCounterCount = sizeof(kCounters) / sizeof(kCounters[0]);
+
+// Group of counters of the calling thread, scheduled together
+class PerfCounters {
+
+    private:
+        vector<int> _fds;
+
+    public:
+        PerfCounters() {
+            for(const Counter& counter : kCounters) {
+                perf_event_attr attr {};
+                attr.size = sizeof(attr);
+                attr.type = counter.type;
+                attr.config = counter.config;
+                attr.disabled = _fds.empty();
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                const int leader = _fds.empty() ? -1 : _fds[0];
+                const int fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+                if(fd < 0) {
+                    cerr << "perf_event_open(" << counter.name << "): " << strerror(errno)
+                         << ", hardware counters disabled" << endl;
+                    close();
+                    return;
+                }
+                _fds.push_back(fd);
+            }
+        }
+
+        ~PerfCounters() {
+            close();
+        }
+
+        inline bool available() const {
+            return !_fds.empty();
+        }
+
+        void start() {
+            if(available()) {
+                ioctl(_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+        }
+
+        // Values in the order of kCounters
+        vector<uint64_t> stop() {
+            vector<uint64_t> values(kCounterCount);
+            if(available()) {
+                ioctl(_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+                vector<uint64_t> buffer(1 + kCounterCount);
+                if(read(_fds[0], buffer.data(), buffer.size() * sizeof(uint64_t)) > 0) {
+                    copy(buffer.begin() + 1, buffer.end(), values.begin());
+                }
+            }
+            return values;
+        }
+
+    private:
+        void close() {
+            for(int fd : _fds) {
+                ::close(fd);
+            }
+            _fds.clear();
+        }
+
+};
+
+// Cost of a timed scope, measured once
+struct HookCost {
+    double  ticks = 0;          // per hook, as seen from outside
+    double  recorded = 0;       // per hook, as recorded by an empty scope
+    double  ticksPerNs = 1;
+};
+
+static HookCost hookCost;
+
+static HookCost measureHooks() {
+    const size_t n = 1000 * 1000;
+    profile::reset();
+    const Clock::time_point start = Clock::now();
+    const uint64_t begin = profile::ticks();
+    for(size_t i = 0; i < n; i++) {
+        profile::Scope scope(profile::Add);
+        asm volatile("" ::: "memory");
+    }
+    const uint64_t end = profile::ticks();
+    const double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+
+    HookCost cost;
+    cost.ticks = double(end - begin) / n;
+    cost.recorded = double(profile::snapshot()[profile::Add].total) / n;
+    cost.ticksPerNs = (end - begin) / ns;
+    profile::reset();
+    return cost;
+}
+
+static void scenario(PerfCounters& counters, const string& name, size_t ops, const function<void()>& body) {
+    profile::reset();
+    counters.start();
+    const Clock::time_point start = Clock::now();
+    body();
+    const double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+    const vector<uint64_t> values = counters.stop();
+
+    cout << "== " << name << ": " << ops << " ops, "
+         << fixed << setprecision(1) << ns / ops << " ns/op" << endl;
+    if(counters.available()) {
+        for(size_t i = 0; i < kCounterCount; i++) {
+            cout << "  " << left << setw(14) << kCounters[i].name << right
+                 << setw(14) << values[i]
+                 << setw(12) << setprecision(2) << double(values[i]) / ops << "/op" << endl;
+        }
+        if(values[0] > 0) {
+            cout << "  IPC " << setprecision(2) << double(values[1]) / values[0] << endl;
+        }
+    }
+    profile::report(cout);
+
+    // Nested hooks are included in the time of the enclosing ones
+    uint64_t hooks = 0;
+    for(const profile::Histogram& histogram : profile::snapshot()) {
+        hooks += histogram.count;
+    }
+    cout << "  hooks " << setprecision(1) << double(hooks) / ops << "/op, about "
+         << hooks * hookCost.ticks / hookCost.ticksPerNs / ops << " ns/op of overhead" << endl;
+    cout << endl;
+}
+
+template <typename Digest>
+static void run(PerfCounters& counters, const string& name, const vector<double>& values) {
+    Digest digest(100);
+    scenario(counters, name + " ingest", values.size(), [&]() {
+        for(double x : values) {
+            digest.add(x);
+        }
+    });
+
+    const size_t parts = 16;
+    vector<unique_ptr<Digest>> digests;
+    for(size_t i = 0; i < parts; i++) {
+        digests.emplace_back(new Digest(100));
+        for(size_t j = i; j < values.size(); j += parts) {
+            digests.back()->add(values[j]);
+        }
+    }
+    Digest merged(100);
+    scenario(counters, name + " merge", parts, [&]() {
+        for(auto& part : digests) {
+            merged.merge(part.get());
+        }
+    });
+
+    const size_t queries = 100 * 1000;
+    volatile double sink = 0;
+    scenario(counters, name + " query", queries, [&]() {
+        for(size_t i = 0; i < queries; i++) {
+            sink = sink + digest.quantile((i % 999 + 1) / 1000.);
+        }
+    });
+}
+
+int main(int argc, char *argv[]) {
+    const size_t samples = argc > 1 ? atol(argv[1]) : 1000 * 1000;
+
+    mt19937_64 gen(1);
+    lognormal_distribution<double> distribution(0, 1.5);
+    vector<double> values(samples);
+    for(double& x : values) {
+        x = distribution(gen);
+    }
+
+    hookCost = measureHooks();
+    cout << "hook: " << fixed << setprecision(1) << hookCost.ticks << " ticks ("
+         << hookCost.ticks / hookCost.ticksPerNs << " ns), "
+         << hookCost.recorded << " ticks recorded by an empty scope" << endl << endl;
+
+    PerfCounters counters;
+    run<TDigest>(counters, "avl", values);
+    run<BasicTDigest<DefaultStorage, BasicArrayTree>>(counters, "array", values);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../tdigest/tdigest.hpp"
+
+
+using namespace std;
+
+//
+// Compares the storage policies:
+// - accuracy: rank error of quantile() against the exact quantiles, next
+//   to the rank error bound of the digest, 2 q (1 - q) / compression
+// - memory: bytes allocated by the tree per centroid, capacity included,
+//   next to the bytes of a node, and bytes of serialized digest
+// - time: ns per add, per quantile query and per merged centroid
+//
+
+static const double kCompression = 100;
+static const double kQuantiles[] = {0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999};
+
+typedef chrono::steady_clock Clock;
+
+static double nanosSince(Clock::time_point start, size_t ops) {
+    return chrono::duration<double, nano>(Clock::now() - start).count() / ops;
+}
+
+// Fraction of the sorted values below x
+static double exactRank(const vector<double>& sorted, double x) {
+    const auto lo = lower_bound(sorted.begin(), sorted.end(), x);
+    const auto hi = upper_bound(sorted.begin(), sorted.end(), x);
+    return ((lo - sorted.begin()) + (hi - sorted.begin())) / 2. / sorted.size();
+}
+
+template <typename Storage>
+static void run(const char* name, const vector<double>& values, const vector<double>& sorted) {
+    typedef BasicTDigest<Storage> Digest;
+
+    Digest digest(kCompression);
+    Clock::time_point start = Clock::now();
+    for(double x : values) {
+        digest.add(x);
+    }
+    const double addNs = nanosSince(start, values.size());
+
+    const size_t queries = 100 * 1000;
+    volatile double sink = 0;
+    start = Clock::now();
+    for(size_t i = 0; i < queries; i++) {
+        sink = sink + digest.quantile((i % 999 + 1) / 1000.);
+    }
+    const double quantileNs = nanosSince(start, queries);
+
+    std::string encoded;
+    digest.serialize(encoded);
+
+    const int parts = 16;
+    Digest merged(kCompression);
+    start = Clock::now();
+    for(int i = 0; i < parts; i++) {
+        merged.merge(encoded.data(), encoded.size());
+    }
+    const double mergeNs = nanosSince(start, parts * digest.centroids()->size());
+
+    cout << name << endl;
+    const size_t centroids = digest.centroids()->size();
+    cout << "  centroids: " << centroids
+         << ", tree bytes/centroid: " << digest.centroids()->allocatedBytes() / centroids
+         << " (node: " << Digest::Tree::nodeBytes() << ")"
+         << ", serialized bytes/centroid: " << encoded.size() / centroids << endl;
+    cout << fixed << setprecision(1)
+         << "  ns/add: " << addNs
+         << ", ns/quantile: " << quantileNs
+         << ", ns/merged centroid: " << mergeNs << endl;
+    cout << "  q         rank error  bound" << endl;
+    for(double q : kQuantiles) {
+        const double error = abs(exactRank(sorted, digest.quantile(q)) - q);
+        cout << "  " << setw(8) << setprecision(3) << q
+             << "  " << setw(10) << setprecision(6) << error
+             << "  " << setw(8) << 2 * q * (1 - q) / kCompression
+             << (error > 2 * q * (1 - q) / kCompression ? "  !" : "") << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const size_t n = argc > 1 ? atol(argv[1]) : 500 * 1000;
+
+    mt19937_64 gen(1);
+    const pair<string, vector<double>> distributions[] = {
+        {"uniform", [&]() {
+            uniform_real_distribution<double> d(0, 1000);
+            vector<double> v(n);
+            for(double& x : v) x = d(gen);
+            return v;
+        }()},
+        {"lognormal", [&]() {
+            lognormal_distribution<double> d(0, 1.5);
+            vector<double> v(n);
+            for(double& x : v) x = d(gen);
+            return v;
+        }()},
+    };
+
+    for(const auto& distribution : distributions) {
+        vector<double> sorted = distribution.second;
+        sort(sorted.begin(), sorted.end());
+
+        cout << "== " << distribution.first << ", " << n << " samples" << endl;
+        run<DefaultStorage>("double mean, 32-bit count", distribution.second, sorted);
+        run<FloatStorage>("float mean, 32-bit count", distribution.second, sorted);
+        run<CompactStorage>("float mean, 16-bit count", distribution.second, sorted);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include "input.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+void ChunkQueue::push(Chunk chunk) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [this] { return _chunks.size() < _capacity; });
+    _chunks.push_back(std::move(chunk));
+    lock.unlock();
+    _notEmpty.notify_one();
+}
+
+void ChunkQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+    }
+    _notEmpty.notify_all();
+}
+
+bool ChunkQueue::pop(Chunk& chunk) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this] { return _closed || !_chunks.empty(); });
+    if(_chunks.empty()) {
+        return false;
+    }
+    chunk = std::move(_chunks.front());
+    _chunks.pop_front();
+    lock.unlock();
+    _notFull.notify_one();
+    return true;
+}
+
+bool mapFile(int fd, size_t chunkSize, ChunkQueue& queue, size_t& bytes) {
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    const size_t size = st.st_size;
+    if(size == 0) {
+        return true;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    // Unmapped once the last chunk has been parsed
+    std::shared_ptr<const void> owner(data, [size](const void* p) {
+        munmap(const_cast<void*>(p), size);
+    });
+
+    const char* begin = static_cast<const char*>(data);
+    const char* const end = begin + size;
+    while(begin < end) {
+        const char* split = begin + std::min(chunkSize, size_t(end - begin));
+        if(split < end) {
+            const void* newline = memchr(split, '\n', end - split);
+            split = newline == nullptr ? end : static_cast<const char*>(newline) + 1;
+        }
+        queue.push(Chunk {begin, split, owner});
+        begin = split;
+    }
+    bytes += size;
+    return true;
+}
+
+bool readStream(int fd, size_t chunkSize, ChunkQueue& queue, size_t& bytes) {
+    // Incomplete last line of the previous buffer
+    std::vector<char> carry;
+    while(true) {
+        auto buffer = std::make_shared<std::vector<char>>(std::max(chunkSize, 2 * carry.size()));
+        memcpy(buffer->data(), carry.data(), carry.size());
+        size_t filled = carry.size();
+
+        bool eof = false;
+        while(filled < buffer->size()) {
+            const ssize_t n = read(fd, buffer->data() + filled, buffer->size() - filled);
+            if(n < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                return false;
+            } else if(n == 0) {
+                eof = true;
+                break;
+            }
+            filled += n;
+            bytes += n;
+        }
+
+        const char* begin = buffer->data();
+        const char* split = begin + filled;
+        if(!eof) {
+            // Keep the incomplete line for the next buffer
+            while(split > begin && split[-1] != '\n') {
+                split--;
+            }
+        }
+        carry.assign(split, begin + filled);
+        if(split > begin) {
+            queue.push(Chunk {begin, split, buffer});
+        }
+        if(eof) {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef HEADER_INPUT
+#define HEADER_INPUT
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+
+using namespace std;
+
+
+// A run of complete lines, kept alive by owner (a mapping or a buffer)
+struct Chunk {
+    const char*                 begin = nullptr;
+    const char*                 end = nullptr;
+    std::shared_ptr<const void> owner;
+};
+
+
+// Bounded queue of chunks between the reader and the parsing threads
+class ChunkQueue {
+
+    private:
+        std::deque<Chunk>           _chunks;
+        size_t                      _capacity;
+        bool                        _closed = false;
+        std::mutex                  _mutex;
+        std::condition_variable     _notEmpty;
+        std::condition_variable     _notFull;
+
+    public:
+        explicit ChunkQueue(size_t capacity): _capacity(capacity) {}
+
+        ChunkQueue(const ChunkQueue&) = delete;
+        void operator = (const ChunkQueue&) = delete;
+
+        // Blocks while the queue is full
+        void push(Chunk chunk);
+
+        // No more chunks will be pushed
+        void close();
+
+        // Blocks while the queue is empty, false once closed and drained
+        bool pop(Chunk& chunk);
+
+};
+
+
+// Maps the file and pushes it in chunks of about chunkSize bytes split on
+// line boundaries. Returns false if the file cannot be mapped (pipes,
+// special files), in which case nothing was pushed.
+bool mapFile(int fd, size_t chunkSize, ChunkQueue& queue, size_t& bytes);
+
+// Reads fd until end of file and pushes it in chunks of about chunkSize
+// bytes split on line boundaries. Returns false on read error.
+bool readStream(int fd, size_t chunkSize, ChunkQueue& queue, size_t& bytes);
+
+#endif
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "../tdigest/parallel.hpp"
+#include "input.hpp"
+#include "parse.hpp"
+
+
+using namespace std;
+
+
+static const size_t kChunkSize = 4 << 20;
+
+static void usage(const char* name) {
+    cerr << "Usage: " << name << " [options] [file...]" << endl
+         << "Computes quantiles of the numbers found in a column of the files," << endl
+         << "or of the standard input when no file (or -) is given." << endl
+         << endl
+         << "  -q, --quantiles LIST    comma separated quantiles (default 0.5,0.9,0.99,0.999)" << endl
+         << "  -c, --compression N     digest compression (default 100)" << endl
+         << "  -f, --field N           column holding the values, from 1 (default 1)" << endl
+         << "  -k, --key N             column to group by, from 1 (default none)" << endl
+         << "  -d, --delimiter C       column delimiter (default runs of blanks)" << endl
+         << "  -t, --threads N         parsing threads (default one per hardware thread)" << endl
+         << "  -s, --serialize         write the serialized digests instead of quantiles" << endl
+         << "  -h, --help" << endl
+         << endl
+         << "With --serialize, each digest is written to the standard output as" << endl
+         << "uint32 key size, key, uint32 digest size, digest (native byte order)." << endl
+         << "Throughput is reported on the standard error." << endl;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    static const struct option longOptions[] = {
+        {"quantiles",   required_argument,  nullptr, 'q'},
+        {"compression", required_argument,  nullptr, 'c'},
+        {"field",       required_argument,  nullptr, 'f'},
+        {"key",         required_argument,  nullptr, 'k'},
+        {"delimiter",   required_argument,  nullptr, 'd'},
+        {"threads",     required_argument,  nullptr, 't'},
+        {"serialize",   no_argument,        nullptr, 's'},
+        {"help",        no_argument,        nullptr, 'h'},
+        {nullptr,       0,                  nullptr, 0},
+    };
+
+    int c;
+    while((c = getopt_long(argc, argv, "q:c:f:k:d:t:sh", longOptions, nullptr)) != -1) {
+        switch(c) {
+            case 'q': {
+                options.quantiles.clear();
+                stringstream list(optarg);
+                string item;
+                while(getline(list, item, ',')) {
+                    char* end;
+                    const double q = strtod(item.c_str(), &end);
+                    if(*end != 0 || q < 0 || q > 1) {
+                        cerr << "invalid quantile: " << item << endl;
+                        return false;
+                    }
+                    options.quantiles.push_back(q);
+                }
+                break;
+            }
+            case 'c':
+                options.compression = atof(optarg);
+                if(options.compression <= 0) {
+                    cerr << "invalid compression: " << optarg << endl;
+                    return false;
+                }
+                break;
+            case 'f':
+                options.valueField = atoi(optarg) - 1;
+                if(options.valueField < 0) {
+                    cerr << "invalid field: " << optarg << endl;
+                    return false;
+                }
+                break;
+            case 'k':
+                options.keyField = atoi(optarg) - 1;
+                if(options.keyField < 0) {
+                    cerr << "invalid key: " << optarg << endl;
+                    return false;
+                }
+                break;
+            case 'd':
+                if(strlen(optarg) != 1) {
+                    cerr << "invalid delimiter: " << optarg << endl;
+                    return false;
+                }
+                options.delimiter = optarg[0];
+                break;
+            case 't': {
+                char* end;
+                const long threads = strtol(optarg, &end, 10);
+                if(*end != 0 || threads <= 0) {
+                    cerr << "invalid threads: " << optarg << endl;
+                    return false;
+                }
+                options.threads = threads;
+                break;
+            }
+            case 's':
+                options.serialize = true;
+                break;
+            case 'h':
+                usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                return false;
+        }
+    }
+
+    for(int i = optind; i < argc; i++) {
+        options.files.push_back(argv[i]);
+    }
+    if(options.files.empty()) {
+        options.files.push_back("-");
+    }
+    if(options.threads == 0) {
+        options.threads = max(1u, thread::hardware_concurrency());
+    }
+    return true;
+}
+
+static void writeSerialized(const string& key, const TDigest& digest) {
+    string encoded;
+    digest.serialize(encoded);
+    const uint32_t keySize = key.size();
+    const uint32_t digestSize = encoded.size();
+    cout.write(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+    cout.write(key.data(), keySize);
+    cout.write(reinterpret_cast<const char*>(&digestSize), sizeof(digestSize));
+    cout.write(encoded.data(), digestSize);
+}
+
+static void writeQuantiles(const Options& options, const string& key, TDigest& digest) {
+    if(options.keyField >= 0) {
+        cout << key << '\t';
+    }
+    cout << digest.size();
+    for(double q : options.quantiles) {
+        cout << '\t' << digest.quantile(q);
+    }
+    cout << '\n';
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if(!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    ChunkQueue queue(2 * options.threads);
+    vector<Partial> partials(options.threads);
+    vector<thread> parsers;
+    for(size_t i = 0; i < options.threads; i++) {
+        parsers.emplace_back([&options, &queue, &partials, i]() {
+            Chunk chunk;
+            while(queue.pop(chunk)) {
+                parse(options, chunk, partials[i]);
+                chunk = Chunk();
+            }
+        });
+    }
+
+    size_t bytes = 0;
+    bool ok = true;
+    for(const string& file : options.files) {
+        const int fd = file == "-" ? STDIN_FILENO : open(file.c_str(), O_RDONLY);
+        if(fd < 0) {
+            cerr << file << ": " << strerror(errno) << endl;
+            ok = false;
+            continue;
+        }
+        if(!mapFile(fd, kChunkSize, queue, bytes) && !readStream(fd, kChunkSize, queue, bytes)) {
+            cerr << file << ": " << strerror(errno) << endl;
+            ok = false;
+        }
+        if(fd != STDIN_FILENO) {
+            close(fd);
+        }
+    }
+    queue.close();
+    for(thread& parser : parsers) {
+        parser.join();
+    }
+
+    // Merge the digests of each key across the parsing threads
+    map<string, vector<TDigest*>> groups;
+    size_t samples = 0;
+    size_t skipped = 0;
+    for(Partial& partial : partials) {
+        for(auto& entry : partial.digests) {
+            groups[entry.first].push_back(entry.second.get());
+        }
+        samples += partial.samples;
+        skipped += partial.skipped;
+    }
+    {
+        ThreadPool pool(options.threads);
+        for(auto& group : groups) {
+            parallelMerge(group.second, pool);
+        }
+    }
+
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if(!options.serialize) {
+        cout << setprecision(10);
+        if(options.keyField >= 0) {
+            cout << "key\t";
+        }
+        cout << "count";
+        for(double q : options.quantiles) {
+            cout << '\t' << q;
+        }
+        cout << '\n';
+    }
+    for(auto& group : groups) {
+        if(options.serialize) {
+            writeSerialized(group.first, *group.second[0]);
+        } else {
+            writeQuantiles(options, group.first, *group.second[0]);
+        }
+    }
+    cout.flush();
+
+    cerr << fixed << setprecision(1)
+         << bytes / 1e6 << " MB, " << samples << " samples, " << skipped << " skipped in "
+         << setprecision(3) << seconds << " s: "
+         << setprecision(1) << bytes / 1e6 / seconds << " MB/s, "
+         << setprecision(0) << samples / seconds << " samples/s" << endl;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
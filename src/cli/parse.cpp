@@ -0,0 +1,101 @@
+#include "parse.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+void parse(const Options& options, const Chunk& chunk, Partial& partial) {
+    const int lastField = max(options.valueField, options.keyField);
+
+    string key;
+    TDigest* digest = nullptr;
+    for(const char* line = chunk.begin; line < chunk.end; ) {
+        const char* newline = static_cast<const char*>(memchr(line, '\n', chunk.end - line));
+        const char* end = newline == nullptr ? chunk.end : newline;
+
+        const char* value = nullptr;
+        const char* valueEnd = nullptr;
+        const char* keyBegin = nullptr;
+        const char* keyEnd = nullptr;
+
+        // Walk the fields up to the last one needed
+        const char* p = line;
+        for(int field = 0; field <= lastField && p <= end; field++) {
+            const char* fieldEnd;
+            if(options.delimiter == 0) {
+                while(p < end && isBlank(*p)) {
+                    p++;
+                }
+                fieldEnd = p;
+                while(fieldEnd < end && !isBlank(*fieldEnd)) {
+                    fieldEnd++;
+                }
+            } else {
+                fieldEnd = static_cast<const char*>(memchr(p, options.delimiter, end - p));
+                if(fieldEnd == nullptr) {
+                    fieldEnd = end;
+                }
+            }
+            if(field == options.valueField) {
+                value = p;
+                valueEnd = fieldEnd;
+            }
+            if(field == options.keyField) {
+                keyBegin = p;
+                keyEnd = fieldEnd;
+            }
+            p = fieldEnd + 1;
+        }
+        const char* const lineBegin = line;
+        line = end + 1;
+
+        if(value == nullptr || value == valueEnd) {
+            // Blank lines are not counted as skipped
+            if(find_if_not(lineBegin, end, isBlank) != end) {
+                partial.skipped++;
+            }
+            continue;
+        }
+
+        double x;
+        // from_chars does not accept a leading '+'
+        if(*value == '+') {
+            value++;
+        }
+        const auto result = from_chars(value, valueEnd, x);
+        if(result.ec != errc() || (result.ptr != valueEnd && !isBlank(*result.ptr)) || !std::isfinite(x)) {
+            partial.skipped++;
+            continue;
+        }
+
+        if(options.keyField < 0) {
+            if(digest == nullptr) {
+                auto& slot = partial.digests[key];
+                if(!slot) {
+                    slot.reset(new TDigest(options.compression));
+                }
+                digest = slot.get();
+            }
+        } else if(keyBegin == nullptr) {
+            partial.skipped++;
+            continue;
+        } else if(digest == nullptr || key.compare(0, string::npos, keyBegin, keyEnd - keyBegin) != 0) {
+            // Consecutive lines often share their key
+            key.assign(keyBegin, keyEnd);
+            auto& slot = partial.digests[key];
+            if(!slot) {
+                slot.reset(new TDigest(options.compression));
+            }
+            digest = slot.get();
+        }
+
+        digest->add(x);
+        partial.samples++;
+    }
+}
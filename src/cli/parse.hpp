@@ -0,0 +1,42 @@
+#ifndef HEADER_PARSE
+#define HEADER_PARSE
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../tdigest/tdigest.hpp"
+#include "input.hpp"
+
+
+using namespace std;
+
+
+struct Options {
+    vector<double>  quantiles {0.5, 0.9, 0.99, 0.999};
+    double          compression = 100;
+    // 0-based, -1 when not grouping
+    int             valueField = 0;
+    int             keyField = -1;
+    // 0 splits on runs of blanks
+    char            delimiter = 0;
+    size_t          threads = 0;
+    bool            serialize = false;
+    vector<string>  files;
+};
+
+// Digests of one parsing thread, by key
+struct Partial {
+    unordered_map<string, unique_ptr<TDigest>>  digests;
+    size_t                                      samples = 0;
+    size_t                                      skipped = 0;
+};
+
+// Adds the values of the lines of the chunk to the digests of partial.
+// Lines whose value field is missing or not a finite number are counted
+// as skipped, blank lines are not.
+void parse(const Options& options, const Chunk& chunk, Partial& partial);
+
+#endif
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../tdigest/tdigest.hpp"
+#include "protocol.hpp"
+
+
+using namespace std;
+
+//
+// Load generator for tdigest-server: each connection keeps up to window
+// batches in flight and records the time from sending a batch to its
+// acknowledgement.
+//
+
+typedef chrono::steady_clock Clock;
+
+// Distinct batches cycled through by each connection
+static const size_t kFrames = 64;
+
+struct Options {
+    string  path;
+    int     port = -1;
+    size_t  connections = 4;
+    size_t  batch = 1000;
+    size_t  window = 8;
+    double  duration = 10;
+    size_t  metrics = 16;
+    bool    digests = false;
+};
+
+struct Result {
+    size_t          samples = 0;
+    vector<double>  latencies;
+    bool            ok = true;
+};
+
+static void usage(const char* name) {
+    cerr << "Usage: " << name << " [options]" << endl
+         << "  -u, --unix PATH         connect to a unix domain socket" << endl
+         << "  -p, --port N            connect to 127.0.0.1:N" << endl
+         << "  -n, --connections N     concurrent connections (default 4)" << endl
+         << "  -b, --batch N           samples per frame (default 1000)" << endl
+         << "  -w, --window N          frames in flight per connection (default 8)" << endl
+         << "  -d, --duration S        seconds (default 10)" << endl
+         << "  -m, --metrics N         distinct metrics (default 16)" << endl
+         << "  -D, --digests           send serialized digests instead of samples" << endl
+         << "  -h, --help" << endl;
+}
+
+static int connectTo(const Options& options) {
+    int fd;
+    if(!options.path.empty()) {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, options.path.c_str(), sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static bool writeFully(int fd, const char* data, size_t size) {
+    while(size > 0) {
+        const ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        } else if(n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool readFully(int fd, char* data, size_t size) {
+    while(size > 0) {
+        const ssize_t n = recv(fd, data, size, 0);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        } else if(n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Reads one response, payload included
+static bool readFrame(int fd, FrameHeader& header, string& payload) {
+    if(!readFully(fd, reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    payload.resize(frameSize(header) - sizeof(header));
+    return readFully(fd, &payload[0], payload.size());
+}
+
+// Frames are prepared up front so that only the server is measured
+static vector<string> prepare(const Options& options, size_t id) {
+    mt19937_64 gen(id);
+    lognormal_distribution<double> distribution(0, 1.5);
+    vector<string> frames(kFrames);
+    vector<double> values(options.batch);
+    for(size_t i = 0; i < kFrames; i++) {
+        for(double& x : values) {
+            x = distribution(gen);
+        }
+        const string metric = "metric." + to_string((id + i) % options.metrics);
+        if(options.digests) {
+            TDigest digest(100);
+            digest.add(values.data(), values.size());
+            string encoded;
+            digest.serialize(encoded);
+            appendFrame(frames[i], Digest, Ok, metric.data(), metric.size(), encoded.data(), encoded.size());
+        } else {
+            appendFrame(frames[i], Samples, Ok, metric.data(), metric.size(), values.data(), values.size() * sizeof(double));
+        }
+    }
+    return frames;
+}
+
+static void run(const Options& options, const vector<string>& frames, Clock::time_point deadline, Result& result) {
+    const int fd = connectTo(options);
+    if(fd < 0) {
+        cerr << "connect: " << strerror(errno) << endl;
+        result.ok = false;
+        return;
+    }
+
+    deque<Clock::time_point> inflight;
+    FrameHeader header;
+    string payload;
+    for(size_t i = 0; ; i++) {
+        const bool sending = Clock::now() < deadline;
+        if(sending && inflight.size() < options.window) {
+            const string& frame = frames[i % kFrames];
+            inflight.push_back(Clock::now());
+            if(!writeFully(fd, frame.data(), frame.size())) {
+                result.ok = false;
+                break;
+            }
+            continue;
+        }
+        if(inflight.empty()) {
+            break;
+        }
+
+        if(!readFrame(fd, header, payload) || header.status != Ok) {
+            result.ok = false;
+            break;
+        }
+        result.latencies.push_back(chrono::duration<double, micro>(Clock::now() - inflight.front()).count());
+        inflight.pop_front();
+        result.samples += options.batch;
+    }
+
+    close(fd);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option longOptions[] = {
+        {"unix",        required_argument,  nullptr, 'u'},
+        {"port",        required_argument,  nullptr, 'p'},
+        {"connections", required_argument,  nullptr, 'n'},
+        {"batch",       required_argument,  nullptr, 'b'},
+        {"window",      required_argument,  nullptr, 'w'},
+        {"duration",    required_argument,  nullptr, 'd'},
+        {"metrics",     required_argument,  nullptr, 'm'},
+        {"digests",     no_argument,        nullptr, 'D'},
+        {"help",        no_argument,        nullptr, 'h'},
+        {nullptr,       0,                  nullptr, 0},
+    };
+
+    Options options;
+    int c;
+    while((c = getopt_long(argc, argv, "u:p:n:b:w:d:m:Dh", longOptions, nullptr)) != -1) {
+        switch(c) {
+            case 'u': options.path = optarg; break;
+            case 'p': options.port = atoi(optarg); break;
+            case 'n': options.connections = atol(optarg); break;
+            case 'b': options.batch = atol(optarg); break;
+            case 'w': options.window = atol(optarg); break;
+            case 'd': options.duration = atof(optarg); break;
+            case 'm': options.metrics = atol(optarg); break;
+            case 'D': options.digests = true; break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if((options.path.empty() && options.port < 0) || options.connections == 0
+            || options.batch == 0 || options.window == 0 || options.metrics == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    vector<vector<string>> frames;
+    for(size_t i = 0; i < options.connections; i++) {
+        frames.push_back(prepare(options, i));
+    }
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(options.duration));
+    vector<Result> results(options.connections);
+    vector<thread> threads;
+    for(size_t i = 0; i < options.connections; i++) {
+        threads.emplace_back(run, cref(options), cref(frames[i]), deadline, ref(results[i]));
+    }
+    for(thread& t : threads) {
+        t.join();
+    }
+    const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    size_t samples = 0;
+    bool ok = true;
+    vector<double> latencies;
+    for(const Result& result : results) {
+        samples += result.samples;
+        ok &= result.ok;
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+    if(latencies.empty()) {
+        cerr << "no frame acknowledged" << endl;
+        return EXIT_FAILURE;
+    }
+    sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double q) {
+        return latencies[min(latencies.size() - 1, size_t(q * latencies.size()))];
+    };
+
+    cout << fixed << setprecision(0)
+         << options.connections << " connections, " << options.batch << " samples per "
+         << (options.digests ? "digest" : "batch") << ", window " << options.window << endl
+         << samples << " samples in " << setprecision(2) << seconds << " s: "
+         << setprecision(0) << samples / seconds << " samples/s, "
+         << latencies.size() / seconds << " frames/s" << endl
+         << setprecision(1)
+         << "ingest latency us: p50 " << percentile(0.5)
+         << ", p99 " << percentile(0.99)
+         << ", max " << latencies.back() << endl;
+
+    // Check the aggregated result of one metric
+    const int fd = connectTo(options);
+    const string metric = "metric.0";
+    const double quantiles[] = {0.5, 0.99};
+    string frame;
+    appendFrame(frame, Query, Ok, metric.data(), metric.size(), quantiles, sizeof(quantiles));
+    FrameHeader header;
+    string payload;
+    if(fd < 0 || !writeFully(fd, frame.data(), frame.size()) || !readFrame(fd, header, payload)
+            || header.status != Ok || header.payloadSize != 3 * sizeof(double)) {
+        cerr << "query failed" << endl;
+        ok = false;
+    } else {
+        const double* results = reinterpret_cast<const double*>(payload.data());
+        cout << setprecision(4) << metric << ": count " << setprecision(0) << results[0]
+             << setprecision(4) << ", p50 " << results[1] << ", p99 " << results[2] << endl;
+    }
+    if(fd >= 0) {
+        close(fd);
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
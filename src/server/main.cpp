@@ -0,0 +1,87 @@
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <getopt.h>
+
+#include "server.hpp"
+
+
+using namespace std;
+
+
+static std::atomic<bool> stopping {false};
+
+static void stop(int) {
+    stopping = true;
+}
+
+static void usage(const char* name) {
+    cerr << "Usage: " << name << " [options]" << endl
+         << "Aggregates the samples and digests sent by local clients into one" << endl
+         << "digest per metric and answers quantile queries (see protocol.hpp)." << endl
+         << endl
+         << "  -u, --unix PATH         listen on a unix domain socket" << endl
+         << "  -p, --port N            listen on 127.0.0.1:N" << endl
+         << "  -c, --compression N     digest compression (default 100)" << endl
+         << "  -h, --help" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option longOptions[] = {
+        {"unix",        required_argument,  nullptr, 'u'},
+        {"port",        required_argument,  nullptr, 'p'},
+        {"compression", required_argument,  nullptr, 'c'},
+        {"help",        no_argument,        nullptr, 'h'},
+        {nullptr,       0,                  nullptr, 0},
+    };
+
+    string path;
+    int port = -1;
+    double compression = 100;
+    int c;
+    while((c = getopt_long(argc, argv, "u:p:c:h", longOptions, nullptr)) != -1) {
+        switch(c) {
+            case 'u':
+                path = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'c':
+                compression = atof(optarg);
+                break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if((path.empty() && port < 0) || port > 65535 || compression <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Server server(compression);
+    if(!path.empty() && !server.listenUnix(path)) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return EXIT_FAILURE;
+    }
+    if(port >= 0 && !server.listenTcp(port)) {
+        cerr << "port " << port << ": " << strerror(errno) << endl;
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    signal(SIGPIPE, SIG_IGN);
+
+    server.run(stopping);
+
+    cerr << "stopped with " << server.metrics() << " metrics" << endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#ifndef HEADER_PROTOCOL
+#define HEADER_PROTOCOL
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+
+using namespace std;
+
+
+//
+// Framing shared by tdigest-server and its clients, native byte order.
+//
+// A frame is a header, the metric name and the payload, both padded to
+// 8 bytes so that frames stay 8-byte aligned in the receive buffer and
+// samples can be read in place as doubles.
+//
+// Requests, each answered by a frame of the same type and a status:
+//   Samples  payload: doubles                 response: no payload
+//   Digest   payload: TDigest::serialize()    response: no payload
+//   Query    payload: quantiles as doubles    response: count then the
+//                                             quantiles, as doubles
+//
+// Samples that are not finite and quantiles out of [0, 1] make the whole
+// frame Malformed.
+//
+
+enum FrameType : uint8_t {
+    Samples = 1,
+    Digest  = 2,
+    Query   = 3,
+};
+
+enum FrameStatus : uint8_t {
+    Ok              = 0,
+    Malformed       = 1,
+    UnknownMetric   = 2,
+};
+
+struct FrameHeader {
+    uint32_t    payloadSize;
+    uint16_t    metricSize;
+    uint8_t     type;
+    uint8_t     status;
+};
+
+static_assert(sizeof(FrameHeader) == 8, "FrameHeader must be 8 bytes");
+
+// Frames larger than this are rejected
+static const size_t kMaxFrameSize = 64 << 20;
+
+inline size_t padded(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+inline size_t frameSize(const FrameHeader& header) {
+    return sizeof(header) + padded(header.metricSize) + padded(header.payloadSize);
+}
+
+inline void appendFrame(std::string& out, uint8_t type, uint8_t status,
+        const char* metric, size_t metricSize,
+        const void* payload, size_t payloadSize) {
+    const FrameHeader header {uint32_t(payloadSize), uint16_t(metricSize), type, status};
+    const size_t offset = out.size();
+    out.resize(offset + frameSize(header), 0);
+    char* p = &out[offset];
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, metric, metricSize);
+    p += padded(metricSize);
+    memcpy(p, payload, payloadSize);
+}
+
+#endif
@@ -0,0 +1,327 @@
+#include "server.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+
+static const size_t kBufferSize = 256 << 10;
+static const int kMaxEvents = 64;
+static const int kTimeoutMs = 100;
+
+Server::Server(double compression): _compression(compression) {
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if(_epoll < 0) {
+        LOG(ERROR) << "epoll_create1: " << strerror(errno);
+    }
+}
+
+Server::~Server() {
+    for(auto& entry : _connections) {
+        ::close(entry.first);
+    }
+    for(int listener : _listeners) {
+        ::close(listener);
+    }
+    if(!_path.empty()) {
+        unlink(_path.c_str());
+    }
+    if(_epoll >= 0) {
+        ::close(_epoll);
+    }
+}
+
+bool Server::addListener(int fd) {
+    if(listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return false;
+    }
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if(epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ::close(fd);
+        return false;
+    }
+    _listeners.push_back(fd);
+    return true;
+}
+
+bool Server::listenUnix(const std::string& path) {
+    sockaddr_un address {};
+    if(path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        return false;
+    }
+    // A previous instance may have left the socket file behind
+    unlink(path.c_str());
+    if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    _path = path;
+    return addListener(fd);
+}
+
+bool Server::listenTcp(uint16_t port) {
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        return false;
+    }
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    return addListener(fd);
+}
+
+void Server::run(const std::atomic<bool>& stopping) {
+    epoll_event events[kMaxEvents];
+    while(!stopping) {
+        const int n = epoll_wait(_epoll, events, kMaxEvents, kTimeoutMs);
+        if(n < 0) {
+            if(errno != EINTR) {
+                LOG(ERROR) << "epoll_wait: " << strerror(errno);
+                return;
+            }
+            continue;
+        }
+
+        for(int i = 0; i < n; i++) {
+            const int fd = events[i].data.fd;
+            if(std::find(_listeners.begin(), _listeners.end(), fd) != _listeners.end()) {
+                accept(fd);
+                continue;
+            }
+            const auto found = _connections.find(fd);
+            if(found == _connections.end()) {
+                // Closed while handling a previous event
+                continue;
+            }
+
+            Connection& connection = *found->second;
+            if((events[i].events & EPOLLIN) || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+                // read() sees the error or the end of stream and closes
+                if(!read(connection)) {
+                    continue;
+                }
+            }
+            if(events[i].events & EPOLLOUT) {
+                write(connection);
+            }
+        }
+    }
+}
+
+void Server::accept(int listener) {
+    while(true) {
+        const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0) {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG(WARNING) << "accept: " << strerror(errno);
+            }
+            return;
+        }
+        // Fails on unix sockets, which do not need it
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if(epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            LOG(WARNING) << "epoll_ctl: " << strerror(errno);
+            ::close(fd);
+            continue;
+        }
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->fd = fd;
+        connection->in.resize(kBufferSize);
+        _connections[fd] = std::move(connection);
+    }
+}
+
+void Server::close(Connection& connection) {
+    const int fd = connection.fd;
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    _connections.erase(fd);
+}
+
+bool Server::read(Connection& c) {
+    while(true) {
+        const ssize_t n = recv(c.fd, c.in.data() + c.end, c.in.size() - c.end, 0);
+        if(n == 0) {
+            close(c);
+            return false;
+        } else if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            LOG(WARNING) << "recv: " << strerror(errno);
+            close(c);
+            return false;
+        }
+        c.end += n;
+
+        // Decode every complete frame in place
+        while(c.end - c.begin >= sizeof(FrameHeader)) {
+            FrameHeader header;
+            memcpy(&header, c.in.data() + c.begin, sizeof(header));
+            const size_t size = frameSize(header);
+            if(size > kMaxFrameSize) {
+                LOG(WARNING) << "frame of " << size << " bytes, closing";
+                close(c);
+                return false;
+            }
+            if(c.end - c.begin < size) {
+                // Make room for the rest of the frame
+                if(c.begin + size > c.in.size()) {
+                    memmove(c.in.data(), c.in.data() + c.begin, c.end - c.begin);
+                    c.end -= c.begin;
+                    c.begin = 0;
+                    if(size > c.in.size()) {
+                        c.in.resize(size);
+                    }
+                }
+                break;
+            }
+
+            const char* metric = c.in.data() + c.begin + sizeof(header);
+            const char* payload = metric + padded(header.metricSize);
+            handle(header, metric, payload, c.out);
+            c.begin += size;
+        }
+
+        if(c.begin == c.end) {
+            c.begin = c.end = 0;
+        } else if(c.end == c.in.size()) {
+            // Only an incomplete header is left at the end
+            memmove(c.in.data(), c.in.data() + c.begin, c.end - c.begin);
+            c.end -= c.begin;
+            c.begin = 0;
+        }
+    }
+
+    return write(c);
+}
+
+bool Server::write(Connection& c) {
+    while(c.offset < c.out.size()) {
+        const ssize_t n = send(c.fd, c.out.data() + c.offset, c.out.size() - c.offset, MSG_NOSIGNAL);
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            close(c);
+            return false;
+        }
+        c.offset += n;
+    }
+
+    const bool pending = c.offset < c.out.size();
+    if(!pending) {
+        c.out.clear();
+        c.offset = 0;
+    }
+    if(pending != c.writing) {
+        // Only wait for writability while responses are pending
+        epoll_event event {};
+        event.events = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.fd = c.fd;
+        epoll_ctl(_epoll, EPOLL_CTL_MOD, c.fd, &event);
+        c.writing = pending;
+    }
+    return true;
+}
+
+void Server::handle(const FrameHeader& header, const char* metric, const char* payload, std::string& out) {
+    uint8_t status = Ok;
+    std::vector<double> results;
+
+    _metric.assign(metric, header.metricSize);
+    if(header.metricSize == 0) {
+        status = Malformed;
+    } else if(header.type == Samples) {
+        // Frames are 8-byte aligned in the receive buffer
+        const double* samples = reinterpret_cast<const double*>(payload);
+        const size_t n = header.payloadSize / sizeof(double);
+        // NaN would break the order of the centroids for every client
+        if(header.payloadSize % sizeof(double) != 0
+                || !std::all_of(samples, samples + n, [](double x) { return std::isfinite(x); })) {
+            status = Malformed;
+        } else if(n > 0) {
+            std::unique_ptr<TDigest>& digest = _digests[_metric];
+            if(!digest) {
+                digest.reset(new TDigest(_compression));
+            }
+            digest->add(samples, n);
+        }
+    } else if(header.type == Digest) {
+        // merge() leaves the digest untouched when malformed, an unknown
+        // metric is only created once the payload merged
+        const auto found = _digests.find(_metric);
+        if(found != _digests.end()) {
+            if(!found->second->merge(payload, header.payloadSize)) {
+                status = Malformed;
+            }
+        } else {
+            std::unique_ptr<TDigest> digest(new TDigest(_compression));
+            if(digest->merge(payload, header.payloadSize)) {
+                _digests[_metric] = std::move(digest);
+            } else {
+                status = Malformed;
+            }
+        }
+    } else if(header.type == Query) {
+        const auto found = _digests.find(_metric);
+        const double* quantiles = reinterpret_cast<const double*>(payload);
+        const size_t n = header.payloadSize / sizeof(double);
+        // Also false for NaN
+        if(header.payloadSize % sizeof(double) != 0
+                || !std::all_of(quantiles, quantiles + n, [](double q) { return q >= 0 && q <= 1; })) {
+            status = Malformed;
+        } else if(found == _digests.end()) {
+            status = UnknownMetric;
+        } else {
+            results.push_back(found->second->size());
+            for(size_t i = 0; i < n; i++) {
+                results.push_back(found->second->quantile(quantiles[i]));
+            }
+        }
+    } else {
+        status = Malformed;
+    }
+
+    appendFrame(out, header.type, status, nullptr, 0, results.data(), results.size() * sizeof(double));
+}
@@ -0,0 +1,74 @@
+#ifndef HEADER_SERVER
+#define HEADER_SERVER
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../tdigest/tdigest.hpp"
+#include "protocol.hpp"
+
+
+using namespace std;
+
+
+// Single threaded epoll server aggregating samples and digests sent by
+// local clients into one digest per metric
+class Server {
+
+    private:
+        struct Connection {
+            int                 fd;
+            // Frames are decoded in place from [begin, end)
+            std::vector<char>   in;
+            size_t              begin = 0;
+            size_t              end = 0;
+            // Responses not yet written from offset
+            std::string         out;
+            size_t              offset = 0;
+            bool                writing = false;
+        };
+
+        double                                                  _compression;
+        int                                                     _epoll = -1;
+        std::vector<int>                                        _listeners;
+        std::string                                             _path;
+        std::unordered_map<int, std::unique_ptr<Connection>>   _connections;
+        std::unordered_map<std::string, std::unique_ptr<TDigest>> _digests;
+        // Reused for metric lookups
+        std::string                                             _metric;
+
+    public:
+        explicit Server(double compression);
+
+        ~Server();
+
+        Server(const Server&) = delete;
+        void operator = (const Server&) = delete;
+
+        // Both can be used together, false on error (see errno)
+        bool listenUnix(const std::string& path);
+        bool listenTcp(uint16_t port);
+
+        // Serves until stopping becomes true
+        void run(const std::atomic<bool>& stopping);
+
+        inline size_t metrics() const {
+            return _digests.size();
+        }
+
+    private:
+        bool addListener(int fd);
+        void accept(int listener);
+        void close(Connection& connection);
+        // false when the connection was closed
+        bool read(Connection& connection);
+        bool write(Connection& connection);
+        // Appends the response to out
+        void handle(const FrameHeader& header, const char* metric, const char* payload, std::string& out);
+
+};
+
+#endif
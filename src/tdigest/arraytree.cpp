@@ -0,0 +1,189 @@
+#include "arraytree.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+
+
+template <typename Storage>
+const int BasicArrayTree<Storage>::NIL;
+
+template <typename Storage>
+BasicArrayTree<Storage>::BasicArrayTree() {
+    _values.push_back(0);
+    _count.push_back(0);
+    rebuildCounts(1);
+}
+
+template <typename Storage>
+void BasicArrayTree<Storage>::addCount(NodeIdx node, AggregatedCount cnt, Sum sum) {
+    for(NodeIdx i = node; i <= size(); i += i & -i) {
+        _countTree[i] += cnt;
+        _sumTree[i] += sum;
+    }
+}
+
+template <typename Storage>
+void BasicArrayTree<Storage>::update(NodeIdx node, ValueType val, Count cnt) {
+    assert(AggregatedCount(count(node)) + cnt <= maxCount());
+    const Sum before = Sum(count(node)) * value(node);
+    _count[node] += cnt;
+    _values[node] += cnt * (val - value(node)) / count(node);
+    addCount(node, cnt, Sum(count(node)) * value(node) - before);
+}
+
+template <typename Storage>
+bool BasicArrayTree<Storage>::add(const ValueType val, const Count cnt) {
+    // First node not below val
+    const NodeIdx node = floor(val) + 1;
+    if(node <= size() && value(node) == val && AggregatedCount(count(node)) + cnt <= maxCount()) {
+        // we merge the node
+        _count[node] += cnt;
+        addCount(node, cnt, Sum(cnt) * val);
+        return false;
+    }
+
+    _values.insert(_values.begin() + node, val);
+    _count.insert(_count.begin() + node, cnt);
+    rebuildCounts(node);
+    return true;
+}
+
+template <typename Storage>
+void BasicArrayTree<Storage>::rebuildCounts(NodeIdx from) {
+    TDIGEST_PROFILE_SCOPE(Rebuild);
+
+    const NodeIdx n = size();
+    for(_highestBit = 1; _highestBit * 2 <= n; _highestBit *= 2);
+
+    if(NodeIdx(n - from) * __builtin_ctz(_highestBit) < n) {
+        // Few nodes moved (appending sorted samples), sum the entries
+        // covered by each moved one
+        _countTree.resize(n + 1);
+        _sumTree.resize(n + 1);
+        for(NodeIdx i = from; i <= n; i++) {
+            AggregatedCount cnt = count(i);
+            Sum sum = Sum(count(i)) * value(i);
+            for(NodeIdx j = i - 1; j > i - (i & -i); j -= j & -j) {
+                cnt += _countTree[j];
+                sum += _sumTree[j];
+            }
+            _countTree[i] = cnt;
+            _sumTree[i] = sum;
+        }
+        return;
+    }
+
+    _countTree.assign(n + 1, 0);
+    _sumTree.assign(n + 1, 0);
+    for(NodeIdx i = 1; i <= n; i++) {
+        _countTree[i] += count(i);
+        _sumTree[i] += Sum(count(i)) * value(i);
+        const NodeIdx parent = i + (i & -i);
+        if(parent <= n) {
+            _countTree[parent] += _countTree[i];
+            _sumTree[parent] += _sumTree[i];
+        }
+    }
+}
+
+template <typename Storage>
+typename BasicArrayTree<Storage>::NodeIdx
+BasicArrayTree<Storage>::find(const ValueType val) const {
+    const NodeIdx node = floor(val) + 1;
+    return node <= size() && value(node) == val ? node : NIL;
+}
+
+template <typename Storage>
+typename BasicArrayTree<Storage>::NodeIdx
+BasicArrayTree<Storage>::floor(const ValueType val) const {
+    NodeIdx n = size();
+    if(n == 0) {
+        return NIL;
+    }
+
+    // Branchless binary search for the first value not below val
+    const ValueType* base = _values.data() + 1;
+    while(n > 1) {
+        const NodeIdx half = n / 2;
+        base = base[half] < val ? base + half : base;
+        n -= half;
+    }
+    return base - _values.data() - 1 + (*base < val);
+}
+
+template <typename Storage>
+typename BasicArrayTree<Storage>::NodeIdx
+BasicArrayTree<Storage>::floorSum(AggregatedCount sum) const {
+    if(size() == 0 || sum < 0) {
+        return NIL;
+    }
+    // Largest node whose prefix count is not above sum
+    NodeIdx node = 0;
+    for(NodeIdx step = _highestBit; step > 0; step /= 2) {
+        if(node + step <= size() && _countTree[node + step] <= sum) {
+            node += step;
+            sum -= _countTree[node];
+        }
+    }
+    // The node after it is the last one starting at or before sum
+    return std::min(node + 1, size());
+}
+
+template <typename Storage>
+typename BasicArrayTree<Storage>::AggregatedCount
+BasicArrayTree<Storage>::ceilSum(const NodeIdx node) const {
+    AggregatedCount sum = 0;
+    for(NodeIdx i = node - 1; i > 0; i -= i & -i) {
+        sum += _countTree[i];
+    }
+    return sum;
+}
+
+template <typename Storage>
+typename BasicArrayTree<Storage>::Sum
+BasicArrayTree<Storage>::ceilWeightedSum(const NodeIdx node) const {
+    Sum sum = 0;
+    for(NodeIdx i = node - 1; i > 0; i -= i & -i) {
+        sum += _sumTree[i];
+    }
+    return sum;
+}
+
+template <typename Storage>
+bool BasicArrayTree<Storage>::checkAggregates() const {
+    AggregatedCount count = 0;
+    Sum sum = 0;
+    for(NodeIdx node = first(); node != NIL; node = nextNode(node)) {
+        if(ceilSum(node) != count
+                || std::abs(ceilWeightedSum(node) - sum) > 1e-9 * std::max<Sum>(1, std::abs(sum))) {
+            return false;
+        }
+        count += this->count(node);
+        sum += Sum(this->count(node)) * value(node);
+    }
+    return this->count(NIL) == 0;
+}
+
+template <typename Storage>
+bool BasicArrayTree<Storage>::checkIntegrity() const {
+    for(NodeIdx node = first(); node != NIL; node = nextNode(node)) {
+        if(node > 1 && value(node - 1) > value(node)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Storage>
+void BasicArrayTree<Storage>::print() const {
+    for(NodeIdx node = first(); node != NIL; node = nextNode(node)) {
+        cout << "Node " << node << "=> ";
+        cout << "Value:" << value(node) << " ";
+        cout << "Count: " << count(node) << " ";
+        cout << "Ceil: " << ceilSum(node) << endl;
+    }
+}
+
+template class BasicArrayTree<DefaultStorage>;
+template class BasicArrayTree<FloatStorage>;
+template class BasicArrayTree<CompactStorage>;
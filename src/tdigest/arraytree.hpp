@@ -0,0 +1,181 @@
+#ifndef HEADER_ARRAYTREE
+#define HEADER_ARRAYTREE
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "avltree.hpp" // storage policies
+
+
+using namespace std;
+
+
+//
+// Centroid index with the interface of BasicAvlTree, backed by arrays:
+// - means and counts sorted by mean, node i being the i-th centroid
+// - a branchless binary search of the sorted means for floor()
+// - Fenwick trees of the counts and of the weighted sums for the rank
+//   queries (floorSum, ceilSum, ceilWeightedSum)
+//
+// Lookups and rank queries are O(log(n)) on contiguous memory. Inserting
+// a centroid shifts the sorted arrays and rebuilds the Fenwick trees from
+// it on, in O(n) at worst, which pays off as long as most samples are
+// merged into existing centroids or appended. Node indices are only
+// stable until the next insertion.
+//
+// The worst case is inserting before most of the nodes, as reverse sorted
+// input does until compress(): every insertion moves and rebuilds all of
+// them, about 8 times the cost per add of BasicAvlTree.
+//
+template <typename Storage = DefaultStorage>
+class BasicArrayTree {
+
+	public:
+        static const int NIL = 0;
+
+		typedef int32_t NodeIdx;
+		typedef typename Storage::ValueType ValueType;
+		typedef typename Storage::Count Count;
+		typedef int64_t AggregatedCount;
+		typedef double Sum;
+
+    private:
+        // Sorted by value, 1-based, index NIL is a zero sentinel
+        std::vector<ValueType>          _values;
+        std::vector<Count>              _count;
+
+        // Fenwick trees over the sorted nodes, 1-based
+        std::vector<AggregatedCount>    _countTree;
+        std::vector<Sum>                _sumTree;
+        // Largest power of 2 not above size(), for the Fenwick descent
+        NodeIdx                         _highestBit = 0;
+
+    public:
+
+        explicit BasicArrayTree();
+
+        BasicArrayTree(const BasicArrayTree&) = delete;
+        BasicArrayTree(BasicArrayTree&&) = delete;
+        void operator = (const BasicArrayTree&) = delete;
+        void operator = (BasicArrayTree&&) = delete;
+
+        // O(1)
+        // Largest count a single node can hold
+        static constexpr int maxCount() {
+            return std::numeric_limits<Count>::max();
+        }
+
+        // O(1)
+        // Bytes used by a node across all the arrays
+        static constexpr size_t nodeBytes() {
+            return sizeof(ValueType) + sizeof(Count) + sizeof(AggregatedCount) + sizeof(Sum);
+        }
+
+        // O(1)
+        // Bytes allocated by the arrays, unused capacity included
+        size_t allocatedBytes() const {
+            return _values.capacity() * sizeof(ValueType) + _count.capacity() * sizeof(Count)
+                + _countTree.capacity() * sizeof(AggregatedCount) + _sumTree.capacity() * sizeof(Sum);
+        }
+
+        //
+        // Tree accessors
+        //
+
+        // O(1)
+        inline NodeIdx size() const {
+            return _values.size() - 1;
+        }
+
+        //
+        // Node accessors
+        //
+
+        // O(1)
+        inline int count(const NodeIdx node) const {
+            return _count[node];
+        }
+        // O(1)
+        inline ValueType value(const NodeIdx node) const {
+            return _values[node];
+        }
+
+        //
+        // Tree accessors
+        //
+
+        // O(1)
+        inline NodeIdx first() const {
+            return size() > 0 ? 1 : NIL;
+        }
+
+        // O(1)
+        inline NodeIdx last() const {
+            return size();
+        }
+
+        // O(1)
+        inline NodeIdx nextNode(NodeIdx node) const {
+            return node != NIL && node < size() ? node + 1 : NIL;
+        }
+
+        // O(1)
+        inline NodeIdx prevNode(NodeIdx node) const {
+            return node != NIL ? node - 1 : NIL;
+        }
+
+        //
+        // Mutators
+        //
+
+        // O(log(n))
+        void update(NodeIdx node, ValueType val, Count cnt);
+
+        // O(n) when a node is inserted, O(log(n)) when merged
+        bool add(const ValueType value, const Count cnt);
+
+        // O(log(n))
+        NodeIdx find(const ValueType value) const;
+
+        // O(log(n))
+        NodeIdx floor(const ValueType value) const;
+
+        // O(log(n))
+        NodeIdx floorSum(AggregatedCount sum) const;
+
+        // O(log(n))
+        AggregatedCount ceilSum(const NodeIdx node) const;
+
+        // O(log(n))
+        // Sum of count * value over the nodes before node
+        Sum ceilWeightedSum(const NodeIdx node) const;
+
+    private:
+        // O(log(n))
+        void addCount(NodeIdx node, AggregatedCount cnt, Sum sum);
+
+        // O(n), O((size() - from) log(n)) when few nodes from on changed
+        void rebuildCounts(NodeIdx from);
+
+    public:
+        // 
+        // For test or debugging purposes
+        //
+
+        // Check the Fenwick trees against the nodes
+        bool checkAggregates() const;
+
+        // Check the order of the nodes
+        bool checkIntegrity() const;
+
+        void print() const;
+
+};
+
+typedef BasicArrayTree<> ArrayTree;
+
+#endif
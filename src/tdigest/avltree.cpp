@@ -1,9 +1,14 @@
 #include "avltree.hpp"
+#include "profile.hpp"
 #include <glog/logging.h>
 
 static constexpr size_t kNumNodes = 10;
 
-AvlTree::AvlTree() {
+template <typename Storage>
+const int BasicAvlTree<Storage>::NIL;
+
+template <typename Storage>
+BasicAvlTree<Storage>::BasicAvlTree() {
 	
 	ExpandNodes();
 	
@@ -13,7 +18,9 @@ AvlTree::AvlTree() {
     _right[NIL]     = 0;
 }
 
-AvlTree::NodeIdx AvlTree::first(NodeIdx node) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::first(NodeIdx node) const {
     if(node == NIL) {
         return NIL;
     }
@@ -28,7 +35,9 @@ AvlTree::NodeIdx AvlTree::first(NodeIdx node) const {
     return node;
 }
 
-AvlTree::NodeIdx AvlTree::last(NodeIdx node) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::last(NodeIdx node) const {
     while(true) {
         const NodeIdx right = rightNode(node);
         if(right == NIL) {
@@ -39,7 +48,9 @@ AvlTree::NodeIdx AvlTree::last(NodeIdx node) const {
     return node;
 }
 
-AvlTree::NodeIdx AvlTree::nextNode(NodeIdx node) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::nextNode(NodeIdx node) const {
     const NodeIdx right = rightNode(node);
     if(right != NIL) {
 		// walk down to leftmost child of right subtree 
@@ -55,7 +66,9 @@ AvlTree::NodeIdx AvlTree::nextNode(NodeIdx node) const {
     }
 }
 
-AvlTree::NodeIdx AvlTree::prevNode(NodeIdx node) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::prevNode(NodeIdx node) const {
     const NodeIdx left = leftNode(node);
     if(left != NIL) {
 		// walk down to rightmost child of left subtree 
@@ -71,7 +84,10 @@ AvlTree::NodeIdx AvlTree::prevNode(NodeIdx node) const {
     }
 }
 
-AvlTree::NodeIdx AvlTree::ExpandNodes() {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::ExpandNodes() {
+	TDIGEST_PROFILE_SCOPE(Expand);
 	const size_t new_size = _parent.size() + kNumNodes;
 	LOG(INFO) << "resized tree from " << _parent.size() << " to " << new_size;
 	_parent.resize(new_size);
@@ -81,11 +97,13 @@ AvlTree::NodeIdx AvlTree::ExpandNodes() {
 	_count.resize(new_size);
 	_values.resize(new_size);
 	_aggregatedCount.resize(new_size);
+	_aggregatedSum.resize(new_size);
 	return 0;
 }
 
-AvlTree::NodeIdx 
-AvlTree::CopyNode(const NodeIdx node, 
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::CopyNode(const NodeIdx node, 
 		const ValueType val, 
 		const Count cnt, 
 		const NodeIdx parent) {
@@ -98,7 +116,8 @@ AvlTree::CopyNode(const NodeIdx node,
 	return 0;
 }
 
-bool AvlTree::add(const ValueType val, const Count cnt) {
+template <typename Storage>
+bool BasicAvlTree<Storage>::add(const ValueType val, const Count cnt) {
     if(_root == NIL) {
         _root = ++_nextNodeIdx;
 		CopyNode(_root, val, cnt, NIL);
@@ -117,6 +136,11 @@ bool AvlTree::add(const ValueType val, const Count cnt) {
             } else if (cmp > 0) {
                 parent = node;
                 node = rightNode(node);
+            } else if (AggregatedCount(count(node)) + cnt > maxCount()) {
+                // the node is full, we insert an equal node on its right
+                parent = node;
+                node = rightNode(node);
+                cmp = 1;
             } else {
                 // we merge the node
                 merge(node, val, cnt);
@@ -142,7 +166,9 @@ bool AvlTree::add(const ValueType val, const Count cnt) {
     }
 }
 
-AvlTree::NodeIdx AvlTree::find(const ValueType val) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::find(const ValueType val) const {
     for(NodeIdx node = _root; node != NIL;) {
         const int cmp = compare(node, val);
         if(cmp < 0) {
@@ -157,7 +183,9 @@ AvlTree::NodeIdx AvlTree::find(const ValueType val) const {
 }
 
 
-AvlTree::NodeIdx AvlTree::floor(const ValueType val) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::floor(const ValueType val) const {
     NodeIdx f = NIL;
     for(NodeIdx node = _root; node != NIL; ) {
         const int cmp = compare(node, val);
@@ -171,11 +199,13 @@ AvlTree::NodeIdx AvlTree::floor(const ValueType val) const {
     return f;
 }
 
-AvlTree::NodeIdx AvlTree::floorSum(Count sum) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::NodeIdx
+BasicAvlTree<Storage>::floorSum(AggregatedCount sum) const {
     NodeIdx f = NIL;
     for(NodeIdx node = _root; node != NIL; ) {
         const NodeIdx left = leftNode(node);
-        const Count leftCount = aggregatedCount(left);
+        const AggregatedCount leftCount = aggregatedCount(left);
         if(leftCount <= sum) {
             f = node;
             sum -= leftCount + count(node);
@@ -187,9 +217,11 @@ AvlTree::NodeIdx AvlTree::floorSum(Count sum) const {
     return f;
 }
 
-AvlTree::Count AvlTree::ceilSum(const NodeIdx node) const {
+template <typename Storage>
+typename BasicAvlTree<Storage>::AggregatedCount
+BasicAvlTree<Storage>::ceilSum(const NodeIdx node) const {
     const NodeIdx left = leftNode(node);
-    Count sum = aggregatedCount(left);
+    AggregatedCount sum = aggregatedCount(left);
     NodeIdx n = node;
     for(NodeIdx p = parentNode(node); p != NIL; p = parentNode(n)) {
         if(n == rightNode(p)) {
@@ -201,7 +233,26 @@ AvlTree::Count AvlTree::ceilSum(const NodeIdx node) const {
     return sum;
 }
 
-void AvlTree::rebalance(const NodeIdx node) {
+template <typename Storage>
+typename BasicAvlTree<Storage>::Sum
+BasicAvlTree<Storage>::ceilWeightedSum(const NodeIdx node) const {
+    const NodeIdx left = leftNode(node);
+    Sum sum = aggregatedSum(left);
+    NodeIdx n = node;
+    for(NodeIdx p = parentNode(node); p != NIL; p = parentNode(n)) {
+        if(n == rightNode(p)) {
+            const NodeIdx leftP = leftNode(p);
+            sum += Sum(count(p)) * value(p) + aggregatedSum(leftP);
+        }
+        n = p;
+    }
+    return sum;
+}
+
+template <typename Storage>
+void BasicAvlTree<Storage>::rebalance(const NodeIdx node) {
+    TDIGEST_PROFILE_SCOPE(Rebalance);
+
     for(NodeIdx n = node; n != NIL; ) {
         const NodeIdx p = parentNode(n);
 
@@ -237,7 +288,8 @@ void AvlTree::rebalance(const NodeIdx node) {
     }
 }
 
-void AvlTree::rotateLeft(const NodeIdx node) {
+template <typename Storage>
+void BasicAvlTree<Storage>::rotateLeft(const NodeIdx node) {
     const NodeIdx r  = rightNode(node);
     const NodeIdx lr = leftNode(r);
 
@@ -262,7 +314,8 @@ void AvlTree::rotateLeft(const NodeIdx node) {
     updateAggregates(parentNode(node));
 }
 
-void AvlTree::rotateRight(const NodeIdx node) {
+template <typename Storage>
+void BasicAvlTree<Storage>::rotateRight(const NodeIdx node) {
     const NodeIdx l = leftNode(node);
     const NodeIdx rl = rightNode(l);
 
@@ -288,7 +341,8 @@ void AvlTree::rotateRight(const NodeIdx node) {
 }
 
 // Check balance integrity
-bool AvlTree::checkBalance(const NodeIdx node) const {
+template <typename Storage>
+bool BasicAvlTree<Storage>::checkBalance(const NodeIdx node) const {
 	if(node == NIL) {
 		return depth(node) == 0;
 	} else {
@@ -300,28 +354,33 @@ bool AvlTree::checkBalance(const NodeIdx node) const {
 	}
 }
 
-bool AvlTree::checkBalance() const {
+template <typename Storage>
+bool BasicAvlTree<Storage>::checkBalance() const {
 	return checkBalance(_root);
 }
 
 // Check aggregates integrity
-bool AvlTree::checkAggregates(const NodeIdx node) const {
+template <typename Storage>
+bool BasicAvlTree<Storage>::checkAggregates(const NodeIdx node) const {
 	if(node == NIL) {
 		return count(node) == 0;
 	} else {
 		return _aggregatedCount[node] == _count[node] + _aggregatedCount[leftNode(node)] + _aggregatedCount[rightNode(node)]
+			&& _aggregatedSum[node] == Sum(_count[node]) * _values[node] + _aggregatedSum[leftNode(node)] + _aggregatedSum[rightNode(node)]
 			&& checkAggregates(leftNode(node))
 			&& checkAggregates(rightNode(node))
 		;
 	}
 }
 
-bool AvlTree::checkAggregates() const {
+template <typename Storage>
+bool BasicAvlTree<Storage>::checkAggregates() const {
 	return checkAggregates(_root);
 }
 
 // Check integrity (order of nodes)
-bool AvlTree::checkIntegrity(const NodeIdx node) const {
+template <typename Storage>
+bool BasicAvlTree<Storage>::checkIntegrity(const NodeIdx node) const {
 	if(node == NIL) {
 		return true;
 	} else {
@@ -338,12 +397,14 @@ bool AvlTree::checkIntegrity(const NodeIdx node) const {
 	}
 }
 
-bool AvlTree::checkIntegrity() const {
+template <typename Storage>
+bool BasicAvlTree<Storage>::checkIntegrity() const {
 	return checkIntegrity(_root);
 }
 
 // Print as rows
-void AvlTree::print(const NodeIdx node) const {
+template <typename Storage>
+void BasicAvlTree<Storage>::print(const NodeIdx node) const {
 	if(node == NIL)
 		return;
 	cout << "Node " << node << "=> ";
@@ -352,10 +413,16 @@ void AvlTree::print(const NodeIdx node) const {
 	cout << "" << _values[rightNode(node)] << ") ";
 	cout << "Depth: " << depth(node) << " ";
 	cout << "Count: " <<_count[node] << " ";
-	cout << "Aggregate: " << _aggregatedCount[node] << endl;
+	cout << "Aggregate: " << _aggregatedCount[node] << " ";
+	cout << "Sum: " << _aggregatedSum[node] << endl;
 	print(leftNode(node));
 	print(rightNode(node));
 }
-void AvlTree::print() const {
+template <typename Storage>
+void BasicAvlTree<Storage>::print() const {
 	print(_root);
 }
+
+template class BasicAvlTree<DefaultStorage>;
+template class BasicAvlTree<FloatStorage>;
+template class BasicAvlTree<CompactStorage>;
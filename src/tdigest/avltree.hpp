@@ -3,22 +3,51 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 
 using namespace std;
 
 
-class AvlTree {
+//
+// Storage policies: the types used to store the mean and the count of
+// each centroid. Aggregates are always kept in full precision.
+//
+
+// 8 bytes mean, 4 bytes count
+struct DefaultStorage {
+    typedef double ValueType;
+    typedef int32_t Count;
+};
+
+// 4 bytes mean, 4 bytes count
+struct FloatStorage {
+    typedef float ValueType;
+    typedef int32_t Count;
+};
+
+// 4 bytes mean, 2 bytes count
+struct CompactStorage {
+    typedef float ValueType;
+    typedef uint16_t Count;
+};
+
+
+template <typename Storage = DefaultStorage>
+class BasicAvlTree {
 
 	public:
         static const int NIL = 0;
 
 		typedef int32_t NodeIdx;
-		typedef double ValueType;
+		typedef typename Storage::ValueType ValueType;
 		typedef int8_t Depth;
-		typedef int32_t Count;
+		typedef typename Storage::Count Count;
+		typedef int64_t AggregatedCount;
+		typedef double Sum;
 
     private:
         NodeIdx       _root {NIL};
@@ -30,16 +59,40 @@ class AvlTree {
         std::vector<Depth>      _depth;
         std::vector<Count>       _count;
         std::vector<ValueType>    _values;
-        std::vector<Count>       _aggregatedCount;
+        std::vector<AggregatedCount>       _aggregatedCount;
+        std::vector<Sum>         _aggregatedSum;
 
     public:
 
-        explicit AvlTree();
+        explicit BasicAvlTree();
+
+        BasicAvlTree(const BasicAvlTree&) = delete;
+        BasicAvlTree(BasicAvlTree&&) = delete;
+        void operator = (const BasicAvlTree&) = delete;
+        void operator = (BasicAvlTree&&) = delete;
 
-        AvlTree(const AvlTree&) = delete;
-        AvlTree(AvlTree&&) = delete;
-        void operator = (const AvlTree&) = delete;
-        void operator = (AvlTree&&) = delete;
+        // O(1)
+        // Largest count a single node can hold
+        static constexpr int maxCount() {
+            return std::numeric_limits<Count>::max();
+        }
+
+        // O(1)
+        // Bytes used by a node across all the arrays
+        static constexpr size_t nodeBytes() {
+            return 3 * sizeof(NodeIdx) + sizeof(Depth) + sizeof(Count)
+                + sizeof(ValueType) + sizeof(AggregatedCount) + sizeof(Sum);
+        }
+
+        // O(1)
+        // Bytes allocated by the arrays, unused capacity included
+        size_t allocatedBytes() const {
+            return _parent.capacity() * sizeof(NodeIdx) + _left.capacity() * sizeof(NodeIdx)
+                + _right.capacity() * sizeof(NodeIdx) + _depth.capacity() * sizeof(Depth)
+                + _count.capacity() * sizeof(Count) + _values.capacity() * sizeof(ValueType)
+                + _aggregatedCount.capacity() * sizeof(AggregatedCount)
+                + _aggregatedSum.capacity() * sizeof(Sum);
+        }
 
         //
         // Node comparison
@@ -99,10 +152,15 @@ class AvlTree {
             return _count[node];
         }
         // O(1)
-        inline int aggregatedCount(const NodeIdx node) const {
+        inline AggregatedCount aggregatedCount(const NodeIdx node) const {
             return _aggregatedCount[node];
         }
         // O(1)
+        // Sum of count * value over the subtree rooted at node
+        inline Sum aggregatedSum(const NodeIdx node) const {
+            return _aggregatedSum[node];
+        }
+        // O(1)
         inline ValueType value(const NodeIdx node) const {
             return _values[node];
         }
@@ -122,6 +180,11 @@ class AvlTree {
         // O(log(n)) 
         NodeIdx last(NodeIdx node) const;
 
+        // O(log(n))
+        inline NodeIdx last() const {
+            return last(_root);
+        }
+
         // O(log(n))
         NodeIdx nextNode(NodeIdx node) const;
 
@@ -137,12 +200,14 @@ class AvlTree {
             // Updating depth
             _depth[node] = 1 + std::max(depth(leftNode(node)), depth(rightNode(node)));
             _aggregatedCount[node] = count(node) + aggregatedCount(leftNode(node)) + aggregatedCount(rightNode(node));
+            _aggregatedSum[node] = Sum(count(node)) * value(node) + aggregatedSum(leftNode(node)) + aggregatedSum(rightNode(node));
         }
 
         // O(log(n))
         void update(NodeIdx node, ValueType val, Count cnt) {
-            _values[node] += cnt * (val - value(node)) / count(node);
+            assert(AggregatedCount(count(node)) + cnt <= maxCount());
             _count[node] += cnt;
+            _values[node] += cnt * (val - value(node)) / count(node);
             
             for(NodeIdx n = node; n != NIL; n = parentNode(n)) {
                updateAggregates(n);
@@ -152,6 +217,7 @@ class AvlTree {
         // O(log(n))
         void merge(NodeIdx node, ValueType val, Count cnt) {
             assert(value(node) == val);
+            assert(AggregatedCount(count(node)) + cnt <= maxCount());
             _count[node] += cnt;
             
             for(NodeIdx n = node; n != NIL; n = parentNode(n)) {
@@ -169,10 +235,14 @@ class AvlTree {
         NodeIdx floor(const ValueType value) const;
 
         // O(log(n))
-        NodeIdx floorSum(const Count sum) const;
+        NodeIdx floorSum(AggregatedCount sum) const;
 
         // O(log(n))
-        Count ceilSum(const NodeIdx node) const;
+        AggregatedCount ceilSum(const NodeIdx node) const;
+
+        // O(log(n))
+        // Sum of count * value over the nodes before node
+        Sum ceilWeightedSum(const NodeIdx node) const;
 
     private:
         // O(1)
@@ -222,4 +292,6 @@ class AvlTree {
 
 };
 
+typedef BasicAvlTree<> AvlTree;
+
 #endif
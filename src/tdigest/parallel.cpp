@@ -0,0 +1,60 @@
+#include "parallel.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+
+template <typename Digest>
+bool parallelMerge(const std::vector<Digest*>& digests,
+        ThreadPool& pool,
+        Deadline deadline,
+        const std::atomic<bool>* cancelled) {
+
+    std::atomic<bool> interrupted {false};
+    auto expired = [&]() {
+        return interrupted
+            || (cancelled != nullptr && *cancelled)
+            || std::chrono::steady_clock::now() >= deadline;
+    };
+
+    std::mutex mutex;
+    std::condition_variable done;
+
+    for(size_t stride = 1; stride < digests.size(); stride *= 2) {
+        if(expired()) {
+            return false;
+        }
+
+        size_t pending = 0;
+        for(size_t i = 0; i + stride < digests.size(); i += 2 * stride) {
+            pending++;
+        }
+
+        for(size_t i = 0; i + stride < digests.size(); i += 2 * stride) {
+            pool.submit([&, i, stride]() {
+                if(expired()) {
+                    interrupted = true;
+                } else {
+                    digests[i]->merge(digests[i + stride]);
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if(--pending == 0) {
+                    done.notify_one();
+                }
+            });
+        }
+
+        // Every merge of this level must be done before the next one
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return pending == 0; });
+    }
+
+    return !interrupted;
+}
+
+template bool parallelMerge(const std::vector<BasicTDigest<DefaultStorage, BasicAvlTree>*>&, ThreadPool&, Deadline, const std::atomic<bool>*);
+template bool parallelMerge(const std::vector<BasicTDigest<FloatStorage, BasicAvlTree>*>&, ThreadPool&, Deadline, const std::atomic<bool>*);
+template bool parallelMerge(const std::vector<BasicTDigest<CompactStorage, BasicAvlTree>*>&, ThreadPool&, Deadline, const std::atomic<bool>*);
+template bool parallelMerge(const std::vector<BasicTDigest<DefaultStorage, BasicArrayTree>*>&, ThreadPool&, Deadline, const std::atomic<bool>*);
+template bool parallelMerge(const std::vector<BasicTDigest<FloatStorage, BasicArrayTree>*>&, ThreadPool&, Deadline, const std::atomic<bool>*);
+template bool parallelMerge(const std::vector<BasicTDigest<CompactStorage, BasicArrayTree>*>&, ThreadPool&, Deadline, const std::atomic<bool>*);
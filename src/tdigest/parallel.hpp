@@ -0,0 +1,36 @@
+#ifndef HEADER_PARALLEL
+#define HEADER_PARALLEL
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "tdigest.hpp"
+#include "threadpool.hpp"
+
+
+using namespace std;
+
+
+typedef std::chrono::steady_clock::time_point Deadline;
+
+//
+// Merges digests into digests[0] as a balanced binary tree: at each level
+// digests[i + stride] is merged into digests[i] for every i multiple of
+// 2 * stride, the merges of a level running concurrently on the pool.
+//
+// The result only depends on the order of the digests, not on the number
+// of threads. The other digests are left partially merged.
+//
+// Returns false, leaving digests[0] incomplete, if the deadline passed or
+// cancelled became true before the reduction completed. Both are checked
+// before each pairwise merge.
+//
+// O(n log(n)) merges spread over the pool, O(log(n)) levels
+template <typename Digest>
+bool parallelMerge(const std::vector<Digest*>& digests,
+        ThreadPool& pool,
+        Deadline deadline = Deadline::max(),
+        const std::atomic<bool>* cancelled = nullptr);
+
+#endif
@@ -0,0 +1,136 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+
+
+namespace profile {
+
+#ifdef TDIGEST_PROFILE
+extern const int libraryBuiltWithProfile = 1;
+#else
+extern const int libraryBuiltWithoutProfile = 1;
+#endif
+
+namespace detail {
+
+__thread Histogram* histograms = nullptr;
+__thread int        suspended = 0;
+
+}
+
+namespace {
+
+struct ThreadHistograms;
+
+std::mutex                      registryMutex;
+std::vector<ThreadHistograms*>  registry;
+// Histograms of the threads that exited
+Histogram                       retired[PhaseCount];
+
+// Registered for as long as its thread runs
+struct ThreadHistograms {
+    Histogram   histograms[PhaseCount];
+
+    ThreadHistograms() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(this);
+    }
+
+    ~ThreadHistograms() {
+        detail::histograms = nullptr;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for(int phase = 0; phase < PhaseCount; phase++) {
+            retired[phase].merge(histograms[phase]);
+        }
+        registry.erase(std::find(registry.begin(), registry.end(), this));
+    }
+};
+
+}
+
+Histogram* detail::registerThread() {
+    static thread_local ThreadHistograms local;
+    histograms = local.histograms;
+    return histograms;
+}
+
+const char* phaseName(Phase phase) {
+    static const char* const names[PhaseCount] = {
+        "add",
+        "add/floor",
+        "add/neighbors",
+        "add/ceilSum",
+        "add/closest",
+        "add/insert",
+        "add/update",
+        "add/compress",
+        "avl/rebalance",
+        "avl/expand",
+        "array/rebuild",
+        "merge",
+        "quantile",
+    };
+    return names[phase];
+}
+
+void Histogram::merge(const Histogram& other) {
+    count += other.count;
+    total += other.total;
+    max = std::max(max, other.max);
+    for(int i = 0; i < kBuckets; i++) {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+uint64_t Histogram::quantile(double q) const {
+    uint64_t seen = 0;
+    for(int i = 0; i < kBuckets; i++) {
+        seen += buckets[i];
+        if(seen > 0 && seen >= q * count) {
+            return i == kBuckets - 1 ? max : std::min((uint64_t(2) << i) - 1, max);
+        }
+    }
+    return max;
+}
+
+std::vector<Histogram> snapshot() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<Histogram> result(retired, retired + PhaseCount);
+    for(const ThreadHistograms* thread : registry) {
+        for(int phase = 0; phase < PhaseCount; phase++) {
+            result[phase].merge(thread->histograms[phase]);
+        }
+    }
+    return result;
+}
+
+void reset() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(int phase = 0; phase < PhaseCount; phase++) {
+        retired[phase] = Histogram();
+        for(ThreadHistograms* thread : registry) {
+            thread->histograms[phase] = Histogram();
+        }
+    }
+}
+
+void report(std::ostream& out) {
+    const std::vector<Histogram> histograms = snapshot();
+    out << "phase              calls   ticks/call          p50          p99          max" << endl;
+    for(int phase = 0; phase < PhaseCount; phase++) {
+        const Histogram& h = histograms[phase];
+        if(h.count == 0) {
+            continue;
+        }
+        out << left << setw(14) << phaseName(Phase(phase)) << right
+            << setw(11) << h.count
+            << setw(13) << fixed << setprecision(1) << double(h.total) / h.count
+            << setw(13) << h.quantile(0.5)
+            << setw(13) << h.quantile(0.99)
+            << setw(13) << h.max << endl;
+    }
+}
+
+}
@@ -0,0 +1,189 @@
+#ifndef HEADER_PROFILE
+#define HEADER_PROFILE
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+
+using namespace std;
+
+
+//
+// Per-phase latency histograms of ingestion, merge and query.
+//
+// Built with TDIGEST_PROFILE defined, the TDIGEST_PROFILE_* macros time
+// their phase and record it in a histogram of the calling thread.
+// Otherwise they expand to nothing and cost nothing.
+//
+// TDigest::add() is inline, so every translation unit that includes
+// tdigest.hpp must agree with the library on TDIGEST_PROFILE: a mismatch
+// would link two definitions of add(), with and without the hooks. Such a
+// mix fails to link on profile::libraryBuiltWithProfile or
+// profile::libraryBuiltWithoutProfile, see the end of this file.
+//
+// Times are in ticks: TSC ticks on x86 (constant rate, close to the
+// nominal frequency), nanoseconds elsewhere.
+//
+namespace profile {
+
+enum Phase {
+    // TDigest::add and its steps
+    Add,
+    Floor,
+    Neighbors,
+    CeilSum,
+    Closest,
+    Insert,
+    Update,
+    Compress,
+    // Index maintenance
+    Rebalance,
+    Expand,
+    Rebuild,
+    // TDigest merges and queries
+    Merge,
+    Quantile,
+
+    PhaseCount
+};
+
+const char* phaseName(Phase phase);
+
+// Counts by power of 2 of ticks
+struct Histogram {
+    static const int kBuckets = 64;
+
+    uint64_t    count = 0;
+    uint64_t    total = 0;
+    uint64_t    max = 0;
+    uint64_t    buckets[kBuckets] = {};
+
+    inline void record(uint64_t ticks) {
+        count++;
+        total += ticks;
+        max = ticks > max ? ticks : max;
+        buckets[63 - __builtin_clzll(ticks | 1)]++;
+    }
+
+    void merge(const Histogram& other);
+
+    // Upper bound of the bucket holding quantile q, at most max
+    uint64_t quantile(double q) const;
+};
+
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+namespace detail {
+
+// State of the calling thread. __thread rather than thread_local: without
+// a constructor, other translation units access it directly instead of
+// through a TLS wrapper call.
+extern __thread Histogram*  histograms;
+extern __thread int         suspended;
+
+// Registers the histograms of the calling thread, on its first record
+Histogram* registerThread();
+
+}
+
+// Records into the histograms of the calling thread
+inline void record(Phase phase, uint64_t ticks) {
+    if(detail::suspended == 0) {
+        Histogram* histograms = detail::histograms;
+        if(__builtin_expect(histograms == nullptr, 0)) {
+            histograms = detail::registerThread();
+        }
+        histograms[phase].record(ticks);
+    }
+}
+
+// Sums the histograms of all the threads, including the exited ones.
+// Threads still recording may be missed partially.
+std::vector<Histogram> snapshot();
+
+// Clears the histograms of all the threads
+void reset();
+
+// While suspended, the hooks of the calling thread record nothing, so that
+// work done on behalf of a phase is only recorded by it. Nests.
+inline void suspend() {
+    detail::suspended++;
+}
+
+inline void resume() {
+    detail::suspended--;
+}
+
+// One line per phase recorded since the last reset
+void report(std::ostream& out);
+
+// Times the enclosing scope
+class Scope {
+
+    private:
+        Phase       _phase;
+        uint64_t    _start;
+
+    public:
+        explicit Scope(Phase phase): _phase(phase), _start(ticks()) {}
+
+        ~Scope() {
+            record(_phase, ticks() - _start);
+        }
+
+};
+
+// Suspends the hooks of the calling thread in the enclosing scope
+class Suspend {
+
+    public:
+        Suspend() {
+            suspend();
+        }
+
+        ~Suspend() {
+            resume();
+        }
+
+};
+
+}
+
+#ifdef TDIGEST_PROFILE
+#define TDIGEST_PROFILE_SCOPE(phase) profile::Scope profileScope(profile::phase)
+#define TDIGEST_PROFILE_BEGIN(phase) const uint64_t profileStart##phase = profile::ticks()
+#define TDIGEST_PROFILE_END(phase) profile::record(profile::phase, profile::ticks() - profileStart##phase)
+#define TDIGEST_PROFILE_SUSPEND() profile::Suspend profileSuspend
+#else
+#define TDIGEST_PROFILE_SCOPE(phase)
+#define TDIGEST_PROFILE_BEGIN(phase)
+#define TDIGEST_PROFILE_END(phase)
+#define TDIGEST_PROFILE_SUSPEND()
+#endif
+
+// Only the one matching the library is defined, by profile.cpp
+namespace profile {
+#ifdef TDIGEST_PROFILE
+extern const int libraryBuiltWithProfile;
+__attribute__((used)) static const int* const profileBuildCheck = &libraryBuiltWithProfile;
+#else
+extern const int libraryBuiltWithoutProfile;
+__attribute__((used)) static const int* const profileBuildCheck = &libraryBuiltWithoutProfile;
+#endif
+}
+
+#endif
@@ -1,12 +1,42 @@
 #include "tdigest.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
-void TDigest::compress() {
-    // TODO: implement this one
+
+template <typename Storage, template <typename> class Index>
+void BasicTDigest<Storage, Index>::compress() {
+    if(_centroids->size() <= 1) {
+        return;
+    }
+    // The adds below are part of the caller's compress phase, not samples
+    TDIGEST_PROFILE_SUSPEND();
+
+    // Adding the centroids again in random order merges those which are
+    // now small enough, in particular after sorted input
+    std::vector<int> nodes;
+    for(int node = _centroids->first(); node != Tree::NIL; node = _centroids->nextNode(node)) {
+        nodes.push_back(node);
+    }
+    std::shuffle(nodes.begin(), nodes.end(), _random);
+
+    BasicTDigest compressed(_compression);
+    compressed._random = _random;
+    for(int node : nodes) {
+        compressed.add(_centroids->value(node), _centroids->count(node));
+    }
+    assert(compressed._count == _count);
+
+    _centroids = std::move(compressed._centroids);
+    _random = compressed._random;
 }
 
 
-double TDigest::quantile(double q) {
+template <typename Storage, template <typename> class Index>
+double BasicTDigest<Storage, Index>::quantile(double q) {
+    TDIGEST_PROFILE_SCOPE(Quantile);
+
     if(q < 0 || q > 1) {
         return 0; // TODO
     }
@@ -22,10 +52,10 @@ double TDigest::quantile(double q) {
     double previousMean = NAN;
     double previousIndex = 0;
     int next = _centroids->floorSum(index);
-    assert(next != AvlTree::NIL);
+    assert(next != Tree::NIL);
     long total = _centroids->ceilSum(next);
     const int prev = _centroids->prevNode(next);
-    if(prev != AvlTree::NIL) {
+    if(prev != Tree::NIL) {
         previousMean = _centroids->value(prev);
         previousIndex = total - (_centroids->count(prev) + 1.0) / 2;
     }
@@ -33,24 +63,24 @@ double TDigest::quantile(double q) {
     while(true) {
         const double nextIndex = total + (_centroids->count(next) - 1.) / 2;
         if(nextIndex >= index) {
-            if(previousMean == NAN) {
+            if(std::isnan(previousMean)) {
                 // Index is before first centroid
                 assert(total == 0);
                 if(nextIndex == previousIndex) {
                     return _centroids->value(next);
                 }
                 // We assume a linear increase
-                int next2 = _centroids->value(next);
+                const int next2 = _centroids->nextNode(next);
                 const double nextIndex2 = total + _centroids->count(next) + (_centroids->count(next2) - 1.) / 2;
                 previousMean = (nextIndex2 * _centroids->value(next) - nextIndex * _centroids->value(next2)) / (nextIndex2 - nextIndex);
             }
-            return quantile(previousIndex, index, nextIndex, previousMean, _centroids->value(next));
+            return std::max(_min, quantile(previousIndex, index, nextIndex, previousMean, _centroids->value(next)));
 
-        } else if(_centroids->value(next) == AvlTree::NIL) {
+        } else if(_centroids->nextNode(next) == Tree::NIL) {
             // Beyond last centroid
             const double nextIndex2 = _count - 1;
             const double nextMean2 = (_centroids->value(next) * (nextIndex2 - previousIndex ) - previousMean * (nextIndex2 - nextIndex)) / (nextIndex - previousIndex);
-            return quantile(nextIndex, index, nextIndex2, _centroids->value(next), nextMean2);
+            return std::min(_max, quantile(nextIndex, index, nextIndex2, _centroids->value(next), nextMean2));
         }
         total += _centroids->count(next);
         previousMean = _centroids->value(next);
@@ -60,3 +90,170 @@ double TDigest::quantile(double q) {
 
 }
 
+template <typename Storage, template <typename> class Index>
+double BasicTDigest<Storage, Index>::cdf(double x) const {
+    if(_centroids->size() == 0) {
+        return NAN;
+    }
+
+    const int first = _centroids->first();
+    const int last = _centroids->last();
+    if(x < _centroids->value(first)) {
+        return 0;
+    } else if(x >= _centroids->value(last)) {
+        return 1;
+    }
+
+    // prev < x <= next, prev is NIL when x is the first mean
+    const int prev = _centroids->floor(x);
+    const int next = prev == Tree::NIL ? first : _centroids->nextNode(prev);
+    const long total = _centroids->ceilSum(next);
+    if(_centroids->value(next) == x) {
+        // Full nodes of a point mass share its mean
+        long count = 0;
+        for(int node = next; node != Tree::NIL && _centroids->value(node) == x; node = _centroids->nextNode(node)) {
+            count += _centroids->count(node);
+        }
+        return (total + count / 2.) / _count;
+    }
+
+    // Each centroid is centered on its mean, interpolate linearly in between
+    const double previousIndex = total - _centroids->count(prev) / 2.;
+    const double nextIndex = total + _centroids->count(next) / 2.;
+    const double w = interpolate(x, _centroids->value(prev), _centroids->value(next));
+    return (previousIndex + w * (nextIndex - previousIndex)) / _count;
+}
+
+template <typename Storage, template <typename> class Index>
+double BasicTDigest<Storage, Index>::countBetween(double a, double b) const {
+    if(_centroids->size() == 0 || b < a) {
+        return 0;
+    }
+    return (cdf(b) - cdf(a)) * _count;
+}
+
+template <typename Storage, template <typename> class Index>
+double BasicTDigest<Storage, Index>::headSum(double rank) const {
+    if(rank <= 0) {
+        return 0;
+    }
+    rank = std::min(rank, _count);
+    const int node = _centroids->floorSum(rank);
+    assert(node != Tree::NIL);
+    const long total = _centroids->ceilSum(node);
+    const double partial = std::min<double>(rank - total, _centroids->count(node));
+    return _centroids->ceilWeightedSum(node) + partial * _centroids->value(node);
+}
+
+template <typename Storage, template <typename> class Index>
+double BasicTDigest<Storage, Index>::trimmedMean(double lo, double hi) const {
+    if(lo < 0 || hi > 1 || lo >= hi || _centroids->size() == 0) {
+        return NAN;
+    }
+
+    const double from = lo * _count;
+    const double to = hi * _count;
+    return (headSum(to) - headSum(from)) / (to - from);
+}
+
+template <typename Storage, template <typename> class Index>
+void BasicTDigest<Storage, Index>::serialize(std::string& out) const {
+    typedef typename Tree::ValueType ValueType;
+    typedef typename Tree::Count Count;
+
+    const uint8_t encoding = sizeof(ValueType) << 4 | sizeof(Count);
+    const uint32_t n = _centroids->size();
+
+    const size_t offset = out.size();
+    out.resize(offset + sizeof(encoding) + sizeof(_compression) + sizeof(n)
+            + n * (sizeof(ValueType) + sizeof(Count)));
+    char* p = &out[offset];
+    memcpy(p, &encoding, sizeof(encoding));
+    p += sizeof(encoding);
+    memcpy(p, &_compression, sizeof(_compression));
+    p += sizeof(_compression);
+    memcpy(p, &n, sizeof(n));
+    p += sizeof(n);
+
+    char* means = p;
+    char* counts = p + n * sizeof(ValueType);
+    for(int node = _centroids->first(); node != Tree::NIL; node = _centroids->nextNode(node)) {
+        const ValueType mean = _centroids->value(node);
+        const Count count = _centroids->count(node);
+        memcpy(means, &mean, sizeof(mean));
+        means += sizeof(mean);
+        memcpy(counts, &count, sizeof(count));
+        counts += sizeof(count);
+    }
+}
+
+namespace {
+
+template <typename ValueType, typename Count, typename Digest>
+bool mergeCentroids(Digest* digest, const char* means, uint32_t n) {
+    const char* counts = means + n * sizeof(ValueType);
+    const auto centroid = [&](uint32_t i, ValueType& mean, Count& count) {
+        memcpy(&mean, means + i * sizeof(ValueType), sizeof(mean));
+        memcpy(&count, counts + i * sizeof(Count), sizeof(count));
+    };
+
+    // Every centroid is checked before any is added, so that a malformed
+    // buffer leaves the digest untouched
+    for(uint32_t i = 0; i < n; i++) {
+        ValueType mean;
+        Count count;
+        centroid(i, mean, count);
+        if(count <= 0 || !std::isfinite(mean)) {
+            return false;
+        }
+    }
+    for(uint32_t i = 0; i < n; i++) {
+        ValueType mean;
+        Count count;
+        centroid(i, mean, count);
+        digest->add(mean, count);
+    }
+    return true;
+}
+
+}
+
+template <typename Storage, template <typename> class Index>
+bool BasicTDigest<Storage, Index>::merge(const char* data, size_t size) {
+    TDIGEST_PROFILE_SCOPE(Merge);
+
+    uint8_t encoding;
+    double compression;
+    uint32_t n;
+    const size_t header = sizeof(encoding) + sizeof(compression) + sizeof(n);
+    if(size < header) {
+        return false;
+    }
+    memcpy(&encoding, data, sizeof(encoding));
+    memcpy(&n, data + sizeof(encoding) + sizeof(compression), sizeof(n));
+
+    const size_t valueSize = encoding >> 4;
+    const size_t countSize = encoding & 0xF;
+    if(size != header + n * (valueSize + countSize)) {
+        return false;
+    }
+
+    const char* means = data + header;
+    switch(encoding) {
+        case sizeof(double) << 4 | sizeof(int32_t):
+            return mergeCentroids<double, int32_t>(this, means, n);
+        case sizeof(float) << 4 | sizeof(int32_t):
+            return mergeCentroids<float, int32_t>(this, means, n);
+        case sizeof(float) << 4 | sizeof(uint16_t):
+            return mergeCentroids<float, uint16_t>(this, means, n);
+        default:
+            return false;
+    }
+}
+
+template class BasicTDigest<DefaultStorage, BasicAvlTree>;
+template class BasicTDigest<FloatStorage, BasicAvlTree>;
+template class BasicTDigest<CompactStorage, BasicAvlTree>;
+template class BasicTDigest<DefaultStorage, BasicArrayTree>;
+template class BasicTDigest<FloatStorage, BasicArrayTree>;
+template class BasicTDigest<CompactStorage, BasicArrayTree>;
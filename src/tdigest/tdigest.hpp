@@ -1,25 +1,45 @@
 #ifndef HEADER_TDIGEST
 #define HEADER_TDIGEST
 
+#include <algorithm>
 #include <cfloat>
+#include <cmath>
 #include <memory> // unique_ptr
+#include <random>
+#include <string>
 
+#include "arraytree.hpp"
 #include "avltree.hpp"
+#include "profile.hpp"
 
 
 using namespace std;
 
 
-class TDigest {
+//
+// Storage is the precision of the centroids, Index the structure holding
+// them: BasicAvlTree or BasicArrayTree.
+//
+template <typename Storage = DefaultStorage, template <typename> class Index = BasicAvlTree>
+class BasicTDigest {
+
+    public:
+        typedef Index<Storage> Tree;
 
     private:
         double    _compression     = 100;
         double    _count           = 0;
-        std::unique_ptr<AvlTree>  _centroids;
+        // Bounds of the samples, extrapolated quantiles stay within them
+        double    _min             = INFINITY;
+        double    _max             = -INFINITY;
+        std::unique_ptr<Tree>  _centroids;
+        // Per digest so that digests can be fed from several threads and
+        // results only depend on the order of the samples
+        std::minstd_rand       _random;
 
     public:
-        TDigest (double compression): _compression(compression) {
-					_centroids = std::make_unique<AvlTree>();
+        BasicTDigest (double compression): _compression(compression) {
+					_centroids = std::make_unique<Tree>();
 				}
 
         inline long size() const {
@@ -30,62 +50,96 @@ class TDigest {
             add(x, 1);
         }
 
+        // O(n log(n))
+        inline void add(const double* values, size_t n) {
+            for(size_t i = 0; i < n; i++) {
+                add(values[i], 1);
+            }
+        }
+
         inline void add(double x, int w) {
+            TDIGEST_PROFILE_SCOPE(Add);
 
+            _min = std::min(_min, x);
+            _max = std::max(_max, x);
+
+            // A centroid cannot hold more than the storage count allows
+            while(w > Tree::maxCount()) {
+                add(x, Tree::maxCount());
+                w -= Tree::maxCount();
+            }
+
+            TDIGEST_PROFILE_BEGIN(Floor);
             int start = _centroids->floor(x);
-            if(start == AvlTree::NIL) {
+            if(start == Tree::NIL) {
                 start = _centroids->first();
             }
+            TDIGEST_PROFILE_END(Floor);
 
-            if(start == AvlTree::NIL) {
+            if(start == Tree::NIL) {
                 assert(_centroids->size() == 0);
                 _centroids->add(x, w);
                 _count += w;
             } else {
+                TDIGEST_PROFILE_BEGIN(Neighbors);
                 double minDistance = DBL_MAX;
-                int lastNeighbor = AvlTree::NIL;
-                for(int neighbor = start; start != AvlTree::NIL; neighbor = _centroids->nextNode(neighbor)) {
+                int lastNeighbor = Tree::NIL;
+                for(int neighbor = start; neighbor != Tree::NIL; neighbor = _centroids->nextNode(neighbor)) {
                     double z = abs(_centroids->value(neighbor) - x);
                     if(z < minDistance) {
                         start = neighbor;
                         minDistance = z;
-                    } else {
+                    } else if(z > minDistance) {
+                        // Centroids at the same distance are all candidates
                         lastNeighbor = neighbor;
                         break;
                     }
                     
                 }
 
-                int closest = AvlTree::NIL;
+                TDIGEST_PROFILE_END(Neighbors);
+
+                TDIGEST_PROFILE_BEGIN(CeilSum);
+                int closest = Tree::NIL;
                 long sum = _centroids->ceilSum(start);
                 double n = 0;
+                TDIGEST_PROFILE_END(CeilSum);
+
+                TDIGEST_PROFILE_BEGIN(Closest);
                 for(int neighbor = start; neighbor != lastNeighbor; neighbor = _centroids->nextNode(neighbor)) {
                     assert(minDistance == abs(_centroids->value(neighbor) - x));
                     double q = _count == 1
                         ? 0.5 
-                        : (sum + (_centroids->count(neighbor) - 1 / 2. )) / (_count - 10) 
+                        : (sum + (_centroids->count(neighbor) - 1) / 2.) / (_count - 1)
                     ;
                     double k = 4 * _count * q * (1 - q) / _compression;
 
-                    if(_centroids->count(neighbor) + w <= k) {
+                    // In 64 bits, count + w may overflow an int
+                    const int64_t count = int64_t(_centroids->count(neighbor)) + w;
+                    if(count <= k && count <= Tree::maxCount()) {
                         n++;
-                        if((float)rand() / RAND_MAX < 1 / n) {
+                        if((float)_random() / _random.max() < 1 / n) {
                             closest = neighbor;
                         }
                     }
                     sum += _centroids->count(neighbor);
 
                 }
+                TDIGEST_PROFILE_END(Closest);
 
-                if(closest == AvlTree::NIL) {
+                if(closest == Tree::NIL) {
+                    TDIGEST_PROFILE_BEGIN(Insert);
                     _centroids->add(x, w);
+                    TDIGEST_PROFILE_END(Insert);
                 } else {
+                    TDIGEST_PROFILE_BEGIN(Update);
                     _centroids->update(closest, x, w);
+                    TDIGEST_PROFILE_END(Update);
                 }
                 _count += w;
 
                 if(_centroids->size() > 20 * _compression) {
-                    cout << "Compress:" << _centroids->size() << endl;
+                    TDIGEST_PROFILE_SCOPE(Compress);
                     compress();
                 }
             }
@@ -100,26 +154,70 @@ class TDigest {
                 double previousIndex, double index, double nextIndex,
                 double previousMean, double nextMean
         ) {
+            // Full nodes of a point mass, exactly on it
+            if(previousMean == nextMean) {
+                return previousMean;
+            }
             const double delta = nextIndex - previousIndex;
             const double previousWeight = (nextIndex - index) / delta;
             const double nextWeight = (index - previousIndex) / delta;
             return previousMean * previousWeight + nextMean * nextWeight;
         }
 
-        inline AvlTree* centroids() const {
+        inline Tree* centroids() const {
             return _centroids.get();
         }
 
-        inline void merge(TDigest* digest) {
-            AvlTree* centroids = digest->centroids();
-            for(int n = centroids->first(); n != AvlTree::NIL; n = centroids->nextNode(n)) {
+        template <typename OtherDigest>
+        inline void merge(OtherDigest* digest) {
+            TDIGEST_PROFILE_SCOPE(Merge);
+            typename OtherDigest::Tree* centroids = digest->centroids();
+            for(int n = centroids->first(); n != Tree::NIL; n = centroids->nextNode(n)) {
                 add(centroids->value(n), centroids->count(n));
             }
         }
 
+        //
+        // Serialization
+        //
+        // Layout (native byte order):
+        //   uint8_t   value size << 4 | count size
+        //   double    compression
+        //   uint32_t  number of centroids
+        //   means     in increasing order, ValueType each
+        //   counts    in the same order, Count each
+        //
+
+        // O(n)
+        // Appends the encoded digest to out
+        void serialize(std::string& out) const;
+
+        // O(n log(n))
+        // Merges an encoded digest of any storage, false if malformed
+        bool merge(const char* data, size_t size);
+
         void compress();
         double quantile(double q);
 
+        // O(log(n))
+        // Fraction of the samples less than or equal to x
+        double cdf(double x) const;
+
+        // O(log(n))
+        // Estimated number of samples in [a, b]
+        double countBetween(double a, double b) const;
+
+        // O(log(n))
+        // Mean of the samples between quantiles lo and hi
+        double trimmedMean(double lo, double hi) const;
+
+    private:
+        // O(log(n))
+        // Sum of the first rank samples, centroids being spread uniformly
+        double headSum(double rank) const;
+
 };
 
+typedef BasicTDigest<> TDigest;
+
 #endif
@@ -0,0 +1,49 @@
+#include "threadpool.hpp"
+
+#include <algorithm>
+
+
+ThreadPool::ThreadPool(size_t threads) {
+    if(threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for(size_t i = 0; i < threads; i++) {
+        _threads.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _available.notify_all();
+    for(std::thread& thread : _threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _available.notify_one();
+}
+
+void ThreadPool::run() {
+    while(true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _available.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+            if(_tasks.empty()) {
+                // stopping and nothing left to run
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
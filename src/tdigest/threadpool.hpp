@@ -0,0 +1,51 @@
+#ifndef HEADER_THREADPOOL
+#define HEADER_THREADPOOL
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+using namespace std;
+
+
+// Fixed size pool of threads running submitted tasks in FIFO order
+class ThreadPool {
+
+    public:
+        typedef std::function<void()> Task;
+
+    private:
+        std::vector<std::thread>    _threads;
+        std::deque<Task>            _tasks;
+        std::mutex                  _mutex;
+        std::condition_variable     _available;
+        bool                        _stopping = false;
+
+    public:
+        // threads == 0 uses one thread per hardware thread
+        explicit ThreadPool(size_t threads = 0);
+
+        // Runs the remaining tasks then joins the threads
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+        void operator = (const ThreadPool&) = delete;
+        void operator = (ThreadPool&&) = delete;
+
+        inline size_t size() const {
+            return _threads.size();
+        }
+
+        void submit(Task task);
+
+    private:
+        void run();
+
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "../tdigest/tdigest.hpp"
+#include "distributions.hpp"
+
+#include <gtest/gtest.h>
+
+static const double quantiles[] = {
+    0.001, 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999
+};
+
+// Streams each distribution into a digest and checks quantile() and cdf()
+// against the exact ranks of the samples
+template <typename Digest>
+static void checkAccuracy(size_t n) {
+    for(Distribution distribution : allDistributions) {
+        SCOPED_TRACE(distributionName(distribution));
+        // Quantiles are interpolated between centroids, up to half of a
+        // point mass away from it
+        const double maxError = distribution == Distribution::Duplicates ? 0.051 : 0.002;
+
+        const vector<double> values = generate(distribution, n);
+        Digest digest(100);
+        for(double x : values) {
+            digest.add(x);
+        }
+        ASSERT_EQ(digest.size(), n);
+        ASSERT_EQ(digest.centroids()->checkAggregates(), true);
+        ASSERT_EQ(digest.centroids()->checkIntegrity(), true);
+        // Compression keeps the number of centroids bounded
+        ASSERT_LT(digest.centroids()->size(), 2000);
+
+        vector<double> sorted(values);
+        sort(sorted.begin(), sorted.end());
+
+        // Often the mean of a single sample centroid at the extremes
+        ASSERT_LE(rankError(sorted, digest.cdf(sorted.front()), sorted.front()), maxError);
+        ASSERT_LE(rankError(sorted, digest.cdf(sorted.back()), sorted.back()), maxError);
+
+        double previous = -INFINITY;
+        for(double q : quantiles) {
+            SCOPED_TRACE(q);
+            const double estimate = digest.quantile(q);
+            ASSERT_GE(estimate, sorted.front());
+            ASSERT_LE(estimate, sorted.back());
+            ASSERT_GE(estimate, previous);
+            ASSERT_LE(rankError(sorted, q, estimate), maxError);
+            previous = estimate;
+
+            const double exact = sorted[size_t(q * (n - 1))];
+            ASSERT_LE(rankError(sorted, digest.cdf(exact), exact), maxError);
+        }
+    }
+}
+
+TEST(AccuracyTest, AvlTreeTest) {
+    checkAccuracy<TDigest>(50000);
+}
+
+TEST(AccuracyTest, ArrayTreeTest) {
+    checkAccuracy<BasicTDigest<DefaultStorage, BasicArrayTree>>(50000);
+}
+
+TEST(AccuracyTest, CompactStorageTest) {
+    checkAccuracy<BasicTDigest<CompactStorage>>(50000);
+}
+
+TEST(AccuracyTest, CompactDuplicatesTest) {
+    // About 100k copies of each value, more than a uint16 node holds, so
+    // that each point mass spans several nodes of the same mean
+    const size_t n = 1000 * 1000;
+    const vector<double> values = generate(Distribution::Duplicates, n);
+    BasicTDigest<CompactStorage> digest(100);
+    digest.add(values.data(), n);
+    ASSERT_GT(digest.centroids()->size(), 10);
+    ASSERT_EQ(digest.centroids()->checkAggregates(), true);
+
+    vector<double> sorted(values);
+    sort(sorted.begin(), sorted.end());
+    for(int i = 1; i < 1000; i++) {
+        const double q = i / 1000.;
+        SCOPED_TRACE(q);
+        const double estimate = digest.quantile(q);
+        ASSERT_LE(rankError(sorted, q, estimate), 0.051);
+    }
+    // Between the nodes of a point mass, exactly on it
+    for(int value = 0; value < 10; value++) {
+        const double first = lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+        const double last = upper_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+        ASSERT_EQ(digest.quantile((first + last) / 2 / n), value);
+    }
+}
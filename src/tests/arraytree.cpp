@@ -0,0 +1,90 @@
+#include "../tdigest/arraytree.hpp"
+#include "../tdigest/avltree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+TEST(ArrayTreeTest, GenericTest) {
+    ArrayTree* tree = new ArrayTree();
+
+    ASSERT_EQ(tree->first(), ArrayTree::NIL);
+    ASSERT_EQ(tree->size(), 0);
+    ASSERT_EQ(tree->floor(1.), ArrayTree::NIL);
+    ASSERT_EQ(tree->floorSum(0), ArrayTree::NIL);
+
+    tree->add(5., 3);
+    tree->add(8., 1);
+    tree->add(9., 2);
+    tree->add(4., 2);
+    tree->add(7., 2);
+    tree->add(6., 2);
+    tree->add(2., 2);
+    tree->add(1., 6);
+    tree->add(3., 6);
+    tree->add(5., 3);
+
+    ASSERT_EQ(tree->size(), 9);
+    ASSERT_EQ(tree->count(tree->find(5.)), 6);
+    ASSERT_EQ(tree->find(5.5), ArrayTree::NIL);
+    ASSERT_EQ(tree->value(tree->floor(5.5)), 5.);
+    ASSERT_EQ(tree->value(tree->floor(5.)), 4.);
+    ASSERT_EQ(tree->floor(1.), ArrayTree::NIL);
+    ASSERT_EQ(tree->floor(100.), tree->last());
+
+    ASSERT_EQ(tree->checkAggregates(), true);
+    ASSERT_EQ(tree->checkIntegrity(), true);
+}
+
+// Every query gives the same answer as the AVL tree
+TEST(ArrayTreeTest, AvlTreeTest) {
+    ArrayTree* array = new ArrayTree();
+    AvlTree* avl = new AvlTree();
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> values(0, 2000);
+
+    for(int i = 0; i < 3000; i++) {
+        const double x = values(gen) / 4.;
+        const int cnt = i % 5 + 1;
+        if(i % 3 == 0 && array->size() > 0) {
+            // Update the centroid before x, keeping the order
+            const int a = array->floor(x);
+            const int b = avl->floor(x);
+            ASSERT_EQ(array->value(a), avl->value(b));
+            if(a != ArrayTree::NIL && array->nextNode(a) != ArrayTree::NIL
+                    && array->value(array->nextNode(a)) >= x) {
+                array->update(a, array->value(a), cnt);
+                avl->update(b, avl->value(b), cnt);
+                continue;
+            }
+        }
+        ASSERT_EQ(array->add(x, cnt), avl->add(x, cnt));
+    }
+
+    ASSERT_EQ(array->size(), avl->size());
+    ASSERT_EQ(array->checkAggregates(), true);
+    ASSERT_EQ(array->checkIntegrity(), true);
+
+    int b = avl->first();
+    for(int a = array->first(); a != ArrayTree::NIL; a = array->nextNode(a)) {
+        ASSERT_EQ(array->value(a), avl->value(b));
+        ASSERT_EQ(array->count(a), avl->count(b));
+        ASSERT_EQ(array->ceilSum(a), avl->ceilSum(b));
+        ASSERT_DOUBLE_EQ(array->ceilWeightedSum(a), avl->ceilWeightedSum(b));
+        ASSERT_EQ(array->prevNode(a) == ArrayTree::NIL, avl->prevNode(b) == AvlTree::NIL);
+        b = avl->nextNode(b);
+    }
+    ASSERT_EQ(b, AvlTree::NIL);
+
+    const int total = avl->aggregatedCount(avl->root());
+    for(int sum = 0; sum <= total; sum += 7) {
+        ASSERT_EQ(array->value(array->floorSum(sum)), avl->value(avl->floorSum(sum)));
+    }
+    for(int i = -10; i < 520; i++) {
+        const double x = i + 0.5;
+        ASSERT_EQ(array->floor(x) == ArrayTree::NIL, avl->floor(x) == AvlTree::NIL);
+        if(array->floor(x) != ArrayTree::NIL) {
+            ASSERT_EQ(array->value(array->floor(x)), avl->value(avl->floor(x)));
+        }
+    }
+}
@@ -32,3 +32,21 @@ TEST(AvlTreeTest, GenericTest) {
     ASSERT_EQ(tree->checkAggregates(), true);
     ASSERT_EQ(tree->checkIntegrity(), true);
 }
+
+TEST(AvlTreeTest, WeightedSumTest) {
+    AvlTree* tree = new AvlTree();
+
+    for(int i = 1; i <= 50; i++) {
+        tree->add(i, i % 3 + 1);
+    }
+    tree->update(tree->find(25.), 26., 2);
+
+    ASSERT_EQ(tree->checkAggregates(), true);
+
+    double sum = 0;
+    for(int n = tree->first(); n != AvlTree::NIL; n = tree->nextNode(n)) {
+        ASSERT_DOUBLE_EQ(tree->ceilWeightedSum(n), sum);
+        sum += tree->count(n) * tree->value(n);
+    }
+    ASSERT_DOUBLE_EQ(tree->aggregatedSum(tree->root()), sum);
+}
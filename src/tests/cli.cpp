@@ -0,0 +1,96 @@
+#include "../cli/parse.hpp"
+
+#include <gtest/gtest.h>
+
+static void parseText(const Options& options, const std::string& text, Partial& partial) {
+    Chunk chunk;
+    chunk.begin = text.data();
+    chunk.end = text.data() + text.size();
+    parse(options, chunk, partial);
+}
+
+static long count(const Partial& partial, const std::string& key) {
+    const auto found = partial.digests.find(key);
+    return found == partial.digests.end() ? -1 : found->second->size();
+}
+
+TEST(CliTest, BlanksTest) {
+    Options options;
+    Partial partial;
+    parseText(options, "1\n  2.5\t\n\n+3\r\n-4e1 trailing\n \t\n5", partial);
+
+    ASSERT_EQ(partial.samples, 5);
+    // Blank lines are not skipped samples
+    ASSERT_EQ(partial.skipped, 0);
+    ASSERT_EQ(count(partial, ""), 5);
+
+    TDigest* digest = partial.digests[""].get();
+    ASSERT_EQ(digest->quantile(0), -40);
+    ASSERT_EQ(digest->quantile(1), 5);
+}
+
+TEST(CliTest, SkippedTest) {
+    Options options;
+    Partial partial;
+    parseText(options, "abc\n1x\nnan\ninf\n-inf\n++1\n1,5\n7\n", partial);
+
+    ASSERT_EQ(partial.samples, 1);
+    ASSERT_EQ(partial.skipped, 7);
+    ASSERT_EQ(count(partial, ""), 1);
+}
+
+TEST(CliTest, FieldTest) {
+    Options options;
+    options.valueField = 2;
+    Partial partial;
+    parseText(options, "a b 1\na  b\t2\na b\n a b 3 c\n", partial);
+
+    // Runs of blanks, leading ones included, separate the fields
+    ASSERT_EQ(partial.samples, 3);
+    ASSERT_EQ(partial.skipped, 1);
+}
+
+TEST(CliTest, KeyTest) {
+    Options options;
+    options.keyField = 0;
+    options.valueField = 1;
+    Partial partial;
+    parseText(options, "x 1\nx 2\ny 3\nx 4\nz\nz 5", partial);
+
+    ASSERT_EQ(partial.samples, 5);
+    ASSERT_EQ(partial.skipped, 1);
+    ASSERT_EQ(count(partial, "x"), 3);
+    ASSERT_EQ(count(partial, "y"), 1);
+    ASSERT_EQ(count(partial, "z"), 1);
+}
+
+TEST(CliTest, DelimiterTest) {
+    Options options;
+    options.delimiter = ',';
+    options.keyField = 1;
+    options.valueField = 2;
+    Partial partial;
+    parseText(options, "a,x,1\nb,x y,2\n,,3\nc,x,\nd,x\ne,y,4,extra\n", partial);
+
+    // Fields may be empty or hold blanks, an empty value is skipped
+    ASSERT_EQ(partial.samples, 4);
+    ASSERT_EQ(partial.skipped, 2);
+    ASSERT_EQ(count(partial, "x"), 1);
+    ASSERT_EQ(count(partial, "x y"), 1);
+    ASSERT_EQ(count(partial, ""), 1);
+    ASSERT_EQ(count(partial, "y"), 1);
+}
+
+TEST(CliTest, ChunksTest) {
+    Options options;
+    options.keyField = 0;
+    options.valueField = 1;
+    Partial partial;
+    parseText(options, "x 1\ny 2\n", partial);
+    parseText(options, "x 3\n", partial);
+
+    // Chunks accumulate into the same digests
+    ASSERT_EQ(partial.samples, 3);
+    ASSERT_EQ(count(partial, "x"), 2);
+    ASSERT_EQ(count(partial, "y"), 1);
+}
@@ -0,0 +1,110 @@
+#ifndef HEADER_DISTRIBUTIONS
+#define HEADER_DISTRIBUTIONS
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+using namespace std;
+
+
+//
+// Sample streams the digests are checked against, the adversarial ones
+// first, shared by the accuracy test and the accuracy benchmark
+//
+enum class Distribution {
+    Sorted,         // increasing uniform values, worst case for insertion
+    Reverse,        // decreasing uniform values
+    Duplicates,     // 10 distinct values, point masses
+    Bimodal,        // two narrow normals far apart, empty middle
+    Cauchy,         // heavy tails on both sides
+    Lognormal,      // heavy right tail
+    Uniform
+};
+
+static const Distribution allDistributions[] = {
+    Distribution::Sorted, Distribution::Reverse, Distribution::Duplicates,
+    Distribution::Bimodal, Distribution::Cauchy, Distribution::Lognormal,
+    Distribution::Uniform
+};
+
+inline const char* distributionName(Distribution distribution) {
+    switch(distribution) {
+        case Distribution::Sorted:      return "sorted";
+        case Distribution::Reverse:     return "reverse";
+        case Distribution::Duplicates:  return "duplicates";
+        case Distribution::Bimodal:     return "bimodal";
+        case Distribution::Cauchy:      return "cauchy";
+        case Distribution::Lognormal:   return "lognormal";
+        case Distribution::Uniform:     return "uniform";
+    }
+    return "";
+}
+
+// Stream of n samples in arrival order, the same for a given seed
+inline vector<double> generate(Distribution distribution, size_t n, uint64_t seed = 1) {
+    mt19937_64 gen(seed);
+    vector<double> values(n);
+
+    switch(distribution) {
+        case Distribution::Sorted:
+        case Distribution::Reverse:
+        case Distribution::Uniform: {
+            uniform_real_distribution<double> uniform(0, 1000);
+            for(double& x : values) {
+                x = uniform(gen);
+            }
+            if(distribution == Distribution::Sorted) {
+                sort(values.begin(), values.end());
+            } else if(distribution == Distribution::Reverse) {
+                sort(values.rbegin(), values.rend());
+            }
+            break;
+        }
+        case Distribution::Duplicates: {
+            uniform_int_distribution<int> uniform(0, 9);
+            for(double& x : values) {
+                x = uniform(gen);
+            }
+            break;
+        }
+        case Distribution::Bimodal: {
+            normal_distribution<double> normal(0, 1);
+            bernoulli_distribution right(0.3);
+            for(double& x : values) {
+                x = normal(gen) + (right(gen) ? 1000 : -1000);
+            }
+            break;
+        }
+        case Distribution::Cauchy: {
+            cauchy_distribution<double> cauchy(0, 1);
+            for(double& x : values) {
+                x = cauchy(gen);
+            }
+            break;
+        }
+        case Distribution::Lognormal: {
+            lognormal_distribution<double> lognormal(0, 1.5);
+            for(double& x : values) {
+                x = lognormal(gen);
+            }
+            break;
+        }
+    }
+    return values;
+}
+
+// Distance between q and the ranks, as fractions of the samples, at which
+// estimate appears in sorted. 0 when estimate is an exact q-quantile, and
+// point masses span all their ranks.
+inline double rankError(const vector<double>& sorted, double q, double estimate) {
+    const double n = sorted.size();
+    const double lo = (lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) / n;
+    const double hi = (upper_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) / n;
+    return q < lo ? lo - q : q > hi ? q - hi : 0;
+}
+
+#endif
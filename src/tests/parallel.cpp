@@ -0,0 +1,70 @@
+#include "../tdigest/parallel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+static std::vector<std::unique_ptr<TDigest>> makeDigests(int count) {
+    std::vector<std::unique_ptr<TDigest>> digests;
+    for(int i = 0; i < count; i++) {
+        digests.emplace_back(new TDigest(100));
+        for(int j = 0; j < 200; j++) {
+            digests.back()->add((i * 7919 + j * 104729) % 1000);
+        }
+    }
+    return digests;
+}
+
+static std::vector<TDigest*> pointers(const std::vector<std::unique_ptr<TDigest>>& digests) {
+    std::vector<TDigest*> result;
+    for(const auto& digest : digests) {
+        result.push_back(digest.get());
+    }
+    return result;
+}
+
+TEST(ParallelTest, MergeTest) {
+    auto digests = makeDigests(37);
+    ThreadPool pool(4);
+
+    ASSERT_TRUE(parallelMerge(pointers(digests), pool));
+    ASSERT_EQ(digests[0]->size(), 37 * 200);
+    ASSERT_EQ(digests[0]->centroids()->checkAggregates(), true);
+    ASSERT_NEAR(digests[0]->quantile(0.5), 500, 10);
+}
+
+TEST(ParallelTest, DeterministicTest) {
+    auto sequential = makeDigests(50);
+    auto concurrent = makeDigests(50);
+    ThreadPool one(1);
+    ThreadPool many(8);
+
+    ASSERT_TRUE(parallelMerge(pointers(sequential), one));
+    ASSERT_TRUE(parallelMerge(pointers(concurrent), many));
+
+    std::string a;
+    std::string b;
+    sequential[0]->serialize(a);
+    concurrent[0]->serialize(b);
+    ASSERT_EQ(a, b);
+}
+
+TEST(ParallelTest, CancelTest) {
+    auto digests = makeDigests(8);
+    ThreadPool pool(2);
+
+    std::atomic<bool> cancelled {true};
+    ASSERT_FALSE(parallelMerge(pointers(digests), pool, Deadline::max(), &cancelled));
+    ASSERT_EQ(digests[0]->size(), 200);
+
+    ASSERT_FALSE(parallelMerge(pointers(digests), pool, std::chrono::steady_clock::now()));
+    ASSERT_EQ(digests[0]->size(), 200);
+}
+
+TEST(ParallelTest, SingleTest) {
+    auto digests = makeDigests(1);
+    ThreadPool pool(2);
+
+    ASSERT_TRUE(parallelMerge(pointers(digests), pool));
+    ASSERT_EQ(digests[0]->size(), 200);
+}
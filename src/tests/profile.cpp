@@ -0,0 +1,77 @@
+#include "../tdigest/profile.hpp"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+TEST(ProfileTest, HistogramTest) {
+    profile::Histogram histogram;
+    ASSERT_EQ(histogram.quantile(0.5), 0);
+
+    for(uint64_t ticks : {3, 5, 6, 7, 1000}) {
+        histogram.record(ticks);
+    }
+
+    ASSERT_EQ(histogram.count, 5);
+    ASSERT_EQ(histogram.total, 1021);
+    ASSERT_EQ(histogram.max, 1000);
+    ASSERT_EQ(histogram.quantile(0.2), 3);
+    ASSERT_EQ(histogram.quantile(0.5), 7);
+    ASSERT_EQ(histogram.quantile(1), 1000);
+}
+
+TEST(ProfileTest, QuantileBelowMaxTest) {
+    profile::Histogram histogram;
+    histogram.record(1393256);
+
+    // The bucket of 1393256 ends at 2097151
+    ASSERT_EQ(histogram.quantile(0.5), 1393256);
+    ASSERT_EQ(histogram.quantile(0.99), 1393256);
+}
+
+TEST(ProfileTest, RecordTest) {
+    profile::reset();
+    profile::record(profile::Merge, 100);
+    profile::record(profile::Merge, 300);
+
+    const std::vector<profile::Histogram> histograms = profile::snapshot();
+    ASSERT_EQ(histograms[profile::Merge].count, 2);
+    ASSERT_EQ(histograms[profile::Merge].total, 400);
+    ASSERT_EQ(histograms[profile::Add].count, 0);
+
+    profile::reset();
+    ASSERT_EQ(profile::snapshot()[profile::Merge].count, 0);
+}
+
+TEST(ProfileTest, ThreadTest) {
+    profile::reset();
+    profile::record(profile::Merge, 100);
+
+    // Registered on its first record, retired when it exits
+    std::thread thread([]() {
+        profile::record(profile::Merge, 200);
+        profile::record(profile::Merge, 300);
+    });
+    thread.join();
+
+    const std::vector<profile::Histogram> histograms = profile::snapshot();
+    ASSERT_EQ(histograms[profile::Merge].count, 3);
+    ASSERT_EQ(histograms[profile::Merge].total, 600);
+    profile::reset();
+}
+
+TEST(ProfileTest, SuspendTest) {
+    profile::reset();
+    {
+        profile::Suspend outer;
+        {
+            profile::Suspend inner;
+            profile::record(profile::Add, 100);
+        }
+        profile::record(profile::Add, 100);
+    }
+    profile::record(profile::Add, 100);
+
+    ASSERT_EQ(profile::snapshot()[profile::Add].count, 1);
+    profile::reset();
+}
@@ -0,0 +1,298 @@
+#include "../server/server.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+// Blocking client of the server under test
+class Client {
+
+    private:
+        int _fd = -1;
+
+    public:
+        explicit Client(const std::string& path) {
+            sockaddr_un address {};
+            address.sun_family = AF_UNIX;
+            memcpy(address.sun_path, path.c_str(), path.size());
+            _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if(connect(_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(_fd);
+                _fd = -1;
+                return;
+            }
+            // Fail rather than hang when a response is missing
+            const timeval timeout {5, 0};
+            setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+
+        ~Client() {
+            if(_fd >= 0) {
+                ::close(_fd);
+            }
+        }
+
+        bool connected() const {
+            return _fd >= 0;
+        }
+
+        void send(const char* data, size_t size) {
+            while(size > 0) {
+                const ssize_t n = ::send(_fd, data, size, MSG_NOSIGNAL);
+                ASSERT_GT(n, 0);
+                data += n;
+                size -= n;
+            }
+        }
+
+        void send(const std::string& data) {
+            send(data.data(), data.size());
+        }
+
+        // Next response, false at the end of the stream
+        bool receive(FrameHeader& header, std::vector<double>& payload) {
+            if(!read(&header, sizeof(header))) {
+                return false;
+            }
+            std::vector<char> rest(frameSize(header) - sizeof(header));
+            if(!read(rest.data(), rest.size())) {
+                return false;
+            }
+            payload.resize(header.payloadSize / sizeof(double));
+            memcpy(payload.data(), rest.data() + padded(header.metricSize), header.payloadSize);
+            return true;
+        }
+
+    private:
+        bool read(void* data, size_t size) {
+            char* p = static_cast<char*>(data);
+            while(size > 0) {
+                const ssize_t n = recv(_fd, p, size, 0);
+                if(n <= 0) {
+                    return false;
+                }
+                p += n;
+                size -= n;
+            }
+            return true;
+        }
+
+};
+
+static std::string frame(uint8_t type, const std::string& metric, const std::vector<double>& payload) {
+    std::string out;
+    appendFrame(out, type, Ok, metric.data(), metric.size(), payload.data(), payload.size() * sizeof(double));
+    return out;
+}
+
+// Serves on a unix socket from another thread
+class ServerTest : public ::testing::Test {
+
+    protected:
+        std::string         _path = "/tmp/tdigest-server-test-" + std::to_string(getpid()) + ".sock";
+        Server              _server {100};
+        std::atomic<bool>   _stopping {false};
+        std::thread         _thread;
+
+        void SetUp() override {
+            ASSERT_TRUE(_server.listenUnix(_path));
+            _thread = std::thread([this]() { _server.run(_stopping); });
+        }
+
+        void TearDown() override {
+            _stopping = true;
+            if(_thread.joinable()) {
+                _thread.join();
+            }
+        }
+
+        // Status of the response to a single request
+        uint8_t request(Client& client, const std::string& data, std::vector<double>* results = nullptr) {
+            client.send(data);
+            FrameHeader header;
+            std::vector<double> payload;
+            if(!client.receive(header, payload)) {
+                return 0xFF;
+            }
+            if(results != nullptr) {
+                *results = payload;
+            }
+            return header.status;
+        }
+
+        // Number of samples of metric, -1 if unknown
+        double count(Client& client, const std::string& metric) {
+            std::vector<double> results;
+            const uint8_t status = request(client, frame(Query, metric, {}), &results);
+            return status == Ok && results.size() == 1 ? results[0] : -1;
+        }
+
+};
+
+TEST_F(ServerTest, SamplesTest) {
+    Client client(_path);
+    ASSERT_TRUE(client.connected());
+
+    std::vector<double> samples;
+    for(int i = 1; i <= 1000; i++) {
+        samples.push_back(i);
+    }
+    ASSERT_EQ(request(client, frame(Samples, "latency", samples)), Ok);
+
+    std::vector<double> results;
+    ASSERT_EQ(request(client, frame(Query, "latency", {0.5}), &results), Ok);
+    ASSERT_EQ(results.size(), 2);
+    ASSERT_EQ(results[0], 1000);
+    ASSERT_NEAR(results[1], 500.5, 5);
+
+    ASSERT_EQ(request(client, frame(Query, "unknown", {0.5})), UnknownMetric);
+
+    // Quantiles out of [0, 1]
+    for(double q : std::vector<double>({NAN, -0.1, 1.1, INFINITY})) {
+        SCOPED_TRACE(q);
+        ASSERT_EQ(request(client, frame(Query, "latency", {0.5, q})), Malformed);
+    }
+}
+
+TEST_F(ServerTest, EmptySamplesTest) {
+    Client client(_path);
+
+    // Nothing to add, the metric is not created
+    ASSERT_EQ(request(client, frame(Samples, "latency", {})), Ok);
+    ASSERT_EQ(count(client, "latency"), -1);
+}
+
+TEST_F(ServerTest, DigestTest) {
+    Client client(_path);
+    TDigest digest(100);
+    for(int i = 1; i <= 1000; i++) {
+        digest.add(i);
+    }
+    std::string encoded;
+    digest.serialize(encoded);
+
+    std::string request;
+    appendFrame(request, Digest, Ok, "latency", 7, encoded.data(), encoded.size());
+    ASSERT_EQ(this->request(client, request), Ok);
+    ASSERT_EQ(count(client, "latency"), 1000);
+
+    // Counts {.., 0, ..} are rejected without creating the metric
+    std::string corrupted(encoded);
+    const int32_t zero = 0;
+    memcpy(&corrupted[corrupted.size() - sizeof(zero)], &zero, sizeof(zero));
+    request.clear();
+    appendFrame(request, Digest, Ok, "other", 5, corrupted.data(), corrupted.size());
+    ASSERT_EQ(this->request(client, request), Malformed);
+    ASSERT_EQ(count(client, "other"), -1);
+}
+
+TEST_F(ServerTest, NonFiniteSamplesTest) {
+    Client client(_path);
+
+    // Rejected before anything is added, the metric is not created
+    ASSERT_EQ(request(client, frame(Samples, "latency", {1, 2, NAN})), Malformed);
+    ASSERT_EQ(count(client, "latency"), -1);
+
+    ASSERT_EQ(request(client, frame(Samples, "latency", {1, 2, 3})), Ok);
+    ASSERT_EQ(request(client, frame(Samples, "latency", {4, INFINITY})), Malformed);
+    ASSERT_EQ(request(client, frame(Samples, "latency", {-INFINITY, 4})), Malformed);
+    ASSERT_EQ(count(client, "latency"), 3);
+
+    std::vector<double> results;
+    ASSERT_EQ(request(client, frame(Query, "latency", {0, 1}), &results), Ok);
+    ASSERT_EQ(results, std::vector<double>({3, 1, 3}));
+}
+
+TEST_F(ServerTest, MalformedTest) {
+    Client client(_path);
+
+    // Unknown type, answered with the same type
+    client.send(frame(9, "latency", {1}));
+    FrameHeader header;
+    std::vector<double> payload;
+    ASSERT_TRUE(client.receive(header, payload));
+    ASSERT_EQ(header.type, 9);
+    ASSERT_EQ(header.status, Malformed);
+
+    // No metric
+    ASSERT_EQ(request(client, frame(Samples, "", {1})), Malformed);
+
+    // Payload not made of doubles
+    std::string odd;
+    const char bytes[3] = {1, 2, 3};
+    appendFrame(odd, Samples, Ok, "latency", 7, bytes, sizeof(bytes));
+    ASSERT_EQ(request(client, odd), Malformed);
+
+    ASSERT_EQ(count(client, "latency"), -1);
+}
+
+TEST_F(ServerTest, SplitFramesTest) {
+    Client client(_path);
+
+    std::string frames;
+    for(int i = 0; i < 3; i++) {
+        frames += frame(Samples, "latency", {1. * i, 10. * i});
+    }
+
+    // Cut inside a header, then inside a metric, then inside a payload
+    const size_t cuts[] = {5, 40, 75, frames.size()};
+    size_t offset = 0;
+    for(size_t cut : cuts) {
+        client.send(frames.data() + offset, cut - offset);
+        offset = cut;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    for(int i = 0; i < 3; i++) {
+        FrameHeader header;
+        std::vector<double> payload;
+        ASSERT_TRUE(client.receive(header, payload));
+        ASSERT_EQ(header.status, Ok);
+    }
+    ASSERT_EQ(count(client, "latency"), 6);
+}
+
+TEST_F(ServerTest, LargeFrameTest) {
+    Client client(_path);
+
+    // Larger than the 256 KB receive buffer, sent after a small frame
+    std::vector<double> samples(100 * 1000);
+    for(size_t i = 0; i < samples.size(); i++) {
+        samples[i] = i % 1000;
+    }
+    std::string frames = frame(Samples, "latency", {1});
+    frames += frame(Samples, "latency", samples);
+    frames += frame(Samples, "latency", {2});
+    client.send(frames);
+
+    for(int i = 0; i < 3; i++) {
+        FrameHeader header;
+        std::vector<double> payload;
+        ASSERT_TRUE(client.receive(header, payload));
+        ASSERT_EQ(header.status, Ok);
+    }
+    ASSERT_EQ(count(client, "latency"), samples.size() + 2);
+}
+
+TEST_F(ServerTest, OversizedFrameTest) {
+    Client client(_path);
+
+    const FrameHeader header {uint32_t(kMaxFrameSize), 7, Samples, Ok};
+    client.send(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // The connection is closed without a response
+    FrameHeader response;
+    std::vector<double> payload;
+    ASSERT_FALSE(client.receive(response, payload));
+
+    Client other(_path);
+    ASSERT_EQ(count(other, "latency"), -1);
+}
@@ -0,0 +1,206 @@
+#include "../tdigest/tdigest.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(TDigestTest, CdfTest) {
+    TDigest* digest = new TDigest(100);
+    ASSERT_TRUE(std::isnan(digest->cdf(0)));
+
+    for(int i = 1; i <= 100; i++) {
+        digest->add(i);
+    }
+
+    ASSERT_EQ(digest->cdf(0), 0);
+    ASSERT_EQ(digest->cdf(100), 1);
+    ASSERT_DOUBLE_EQ(digest->cdf(50), 0.495);
+    ASSERT_DOUBLE_EQ(digest->cdf(50.5), 0.5);
+    // Half of the first centroid at the minimum
+    ASSERT_DOUBLE_EQ(digest->cdf(1), 0.005);
+    ASSERT_DOUBLE_EQ(digest->countBetween(1, 100), 99.5);
+    ASSERT_EQ(digest->countBetween(1, 1), 0);
+
+    TDigest* negative = new TDigest(100);
+    negative->add(-3);
+    negative->add(-3);
+    negative->add(7);
+    ASSERT_DOUBLE_EQ(negative->cdf(-3), 1. / 3);
+
+    // A point mass spread over several full nodes
+    BasicTDigest<CompactStorage>* compact = new BasicTDigest<CompactStorage>(100);
+    compact->add(5, 100000);
+    compact->add(6);
+    ASSERT_GT(compact->centroids()->size(), 2);
+    ASSERT_DOUBLE_EQ(compact->cdf(5), 50000. / 100001);
+    compact->add(4);
+    ASSERT_DOUBLE_EQ(compact->cdf(5), 50001. / 100002);
+}
+
+TEST(TDigestTest, CountBetweenTest) {
+    TDigest* digest = new TDigest(100);
+    for(int i = 1; i <= 100; i++) {
+        digest->add(i);
+    }
+
+    ASSERT_DOUBLE_EQ(digest->countBetween(10.5, 20.5), 10);
+    ASSERT_DOUBLE_EQ(digest->countBetween(-10, 200), 100);
+    ASSERT_EQ(digest->countBetween(20, 10), 0);
+}
+
+TEST(TDigestTest, TrimmedMeanTest) {
+    TDigest* digest = new TDigest(100);
+    ASSERT_TRUE(std::isnan(digest->trimmedMean(0, 1)));
+
+    for(int i = 1; i <= 100; i++) {
+        digest->add(i);
+    }
+
+    ASSERT_DOUBLE_EQ(digest->trimmedMean(0, 1), 50.5);
+    ASSERT_DOUBLE_EQ(digest->trimmedMean(0.1, 0.9), 50.5);
+    ASSERT_DOUBLE_EQ(digest->trimmedMean(0, 0.5), 25.5);
+    ASSERT_TRUE(std::isnan(digest->trimmedMean(0.5, 0.5)));
+}
+
+TEST(TDigestTest, CompactCountOverflowTest) {
+    BasicTDigest<CompactStorage>* digest = new BasicTDigest<CompactStorage>(100);
+    for(int i = 0; i < 100000; i++) {
+        digest->add(42);
+    }
+    digest->add(7, 200000);
+
+    ASSERT_EQ(digest->size(), 300000);
+    ASSERT_EQ(digest->centroids()->aggregatedCount(digest->centroids()->root()), 300000);
+    ASSERT_EQ(digest->centroids()->checkAggregates(), true);
+    ASSERT_EQ(digest->centroids()->checkIntegrity(), true);
+}
+
+template <typename Digest>
+static void checkLargeCounts() {
+    Digest digest(100);
+    digest.add(1, 2000000000);
+    digest.add(1, 2000000000);
+    digest.add(2, 2000000000);
+
+    ASSERT_EQ(digest.size(), 6000000000);
+    ASSERT_EQ(digest.centroids()->ceilSum(digest.centroids()->last()), 4000000000);
+    ASSERT_EQ(digest.centroids()->checkAggregates(), true);
+    ASSERT_EQ(digest.quantile(0.1), 1);
+    ASSERT_EQ(digest.quantile(0.5), 1);
+    ASSERT_EQ(digest.quantile(0.9), 2);
+    ASSERT_DOUBLE_EQ(digest.cdf(1.5), 4. / 6);
+    ASSERT_DOUBLE_EQ(digest.trimmedMean(0, 1), 4. / 3);
+}
+
+TEST(TDigestTest, LargeCountTest) {
+    checkLargeCounts<TDigest>();
+    checkLargeCounts<BasicTDigest<DefaultStorage, BasicArrayTree>>();
+}
+
+TEST(TDigestTest, SerializeTest) {
+    TDigest* digest = new TDigest(100);
+    for(int i = 1; i <= 1000; i++) {
+        digest->add(i % 97 + i / 1000.);
+    }
+
+    std::string encoded;
+    digest->serialize(encoded);
+
+    TDigest* copy = new TDigest(100);
+    ASSERT_TRUE(copy->merge(encoded.data(), encoded.size()));
+    ASSERT_EQ(copy->size(), digest->size());
+    ASSERT_EQ(copy->centroids()->size(), digest->centroids()->size());
+    for(double q = 0.01; q < 1; q += 0.01) {
+        ASSERT_DOUBLE_EQ(copy->quantile(q), digest->quantile(q));
+    }
+
+    ASSERT_FALSE(copy->merge(encoded.data(), encoded.size() - 1));
+    ASSERT_EQ(copy->size(), digest->size());
+}
+
+TEST(TDigestTest, MergeMalformedTest) {
+    TDigest* digest = new TDigest(100);
+    for(int i = 1; i <= 1000; i++) {
+        digest->add(i);
+    }
+    TDigest* source = new TDigest(100);
+    for(int i = 1; i <= 100; i++) {
+        source->add(i * 3);
+    }
+    std::string encoded;
+    source->serialize(encoded);
+
+    const size_t n = source->centroids()->size();
+    const size_t means = 13;
+    const size_t counts = means + n * sizeof(double);
+    std::vector<double> before;
+    for(double q = 0.01; q < 1; q += 0.01) {
+        before.push_back(digest->quantile(q));
+    }
+
+    // Corrupt the last centroid only, after valid ones
+    for(double mean : {NAN, INFINITY, -INFINITY}) {
+        std::string corrupted(encoded);
+        memcpy(&corrupted[means + (n - 1) * sizeof(double)], &mean, sizeof(mean));
+        ASSERT_FALSE(digest->merge(corrupted.data(), corrupted.size()));
+    }
+    for(int32_t count : {0, -5}) {
+        std::string corrupted(encoded);
+        memcpy(&corrupted[counts + (n - 1) * sizeof(int32_t)], &count, sizeof(count));
+        ASSERT_FALSE(digest->merge(corrupted.data(), corrupted.size()));
+    }
+
+    ASSERT_EQ(digest->size(), 1000);
+    std::vector<double> after;
+    for(double q = 0.01; q < 1; q += 0.01) {
+        after.push_back(digest->quantile(q));
+    }
+    ASSERT_EQ(after, before);
+
+    ASSERT_TRUE(digest->merge(encoded.data(), encoded.size()));
+    ASSERT_EQ(digest->size(), 1100);
+}
+
+TEST(TDigestTest, SerializeCompactTest) {
+    TDigest* digest = new TDigest(100);
+    BasicTDigest<CompactStorage>* compact = new BasicTDigest<CompactStorage>(100);
+    for(int i = 1; i <= 1000; i++) {
+        digest->add(i);
+        compact->add(i);
+    }
+
+    std::string encoded;
+    std::string encodedCompact;
+    digest->serialize(encoded);
+    compact->serialize(encodedCompact);
+    ASSERT_EQ(encodedCompact.size() - 13, (encoded.size() - 13) / 2);
+
+    // Compact digests decode into full precision ones and conversely
+    TDigest* copy = new TDigest(100);
+    ASSERT_TRUE(copy->merge(encodedCompact.data(), encodedCompact.size()));
+    BasicTDigest<CompactStorage>* compactCopy = new BasicTDigest<CompactStorage>(100);
+    ASSERT_TRUE(compactCopy->merge(encoded.data(), encoded.size()));
+    for(double q = 0.01; q < 1; q += 0.01) {
+        ASSERT_DOUBLE_EQ(copy->quantile(q), compact->quantile(q));
+        ASSERT_NEAR(compactCopy->quantile(q), digest->quantile(q), 1e-3);
+    }
+}
+
+TEST(TDigestTest, ArrayTreeTest) {
+    TDigest* avl = new TDigest(100);
+    BasicTDigest<DefaultStorage, BasicArrayTree>* array = new BasicTDigest<DefaultStorage, BasicArrayTree>(100);
+    for(int i = 0; i < 20000; i++) {
+        const double x = (i * 7919) % 10007 / 10.;
+        avl->add(x);
+        array->add(x);
+    }
+
+    ASSERT_EQ(array->centroids()->size(), avl->centroids()->size());
+    ASSERT_EQ(array->centroids()->checkAggregates(), true);
+    ASSERT_EQ(array->centroids()->checkIntegrity(), true);
+    for(double q = 0.01; q < 1; q += 0.01) {
+        ASSERT_DOUBLE_EQ(array->quantile(q), avl->quantile(q));
+        ASSERT_NEAR(array->trimmedMean(0, q), avl->trimmedMean(0, q), 1e-9);
+    }
+    for(double x = 0; x < 1000; x += 10) {
+        ASSERT_DOUBLE_EQ(array->cdf(x), avl->cdf(x));
+    }
+}